@@ -42,7 +42,7 @@
  *  This number includes the idle proc, although it is considered a system proc.
  *  The idle proc. has always id 0. The highest ID is MAX_NUMBER_OF_PROCESSES-1.
  */
-#define MAX_NUMBER_OF_PROCESSES 2
+#define MAX_NUMBER_OF_PROCESSES 3
 
 //! Standard priority for newly created processes
 #define DEFAULT_PRIORITY 2
@@ -59,6 +59,9 @@
 //! Number to specify an invalid process
 #define INVALID_PROCESS 255
 
+//! Priority of the task manager process
+#define TASKMAN_PRIORITY 255
+
 //----------------------------------------------------------------------------
 // Stack constants
 //----------------------------------------------------------------------------
@@ -96,6 +99,13 @@
 #define EXTHEAP_MAP_START   (0x0)
 #define EXTHEAP_USE_START   (EXTHEAP_MAP_START + EXTHEAP_MAP_SIZE)
 
+// zweite haelfte des 23LC1024 (extSRAMHigh), gleiche aufteilung
+#define EXTHEAP2_TOTAL_SIZE EXTHEAP_TOTAL_SIZE
+#define EXTHEAP2_MAP_SIZE   EXTHEAP_MAP_SIZE
+#define EXTHEAP2_USE_SIZE   EXTHEAP_USE_SIZE
+#define EXTHEAP2_MAP_START  EXTHEAP_MAP_START
+#define EXTHEAP2_USE_START  EXTHEAP_USE_START
+
 
 
 //////////////////////////////////////
@@ -121,5 +131,8 @@
 //! The bottom of the memory chunk with number PID.
 #define PROCESS_STACK_BOTTOM(PID) (BOTTOM_OF_PROCS_STACK - ((PID)*STACK_SIZE_PROC))
 
+//! The lowest address of all process stacks. .data and .bss have to end below it, checked by os_init.
+#define TOP_OF_PROCS_STACKS (PROCESS_STACK_BOTTOM(MAX_NUMBER_OF_PROCESSES) + 1)
+
 
 #endif
@@ -5,55 +5,125 @@
  *  Author: yousef
  */ 
 #include "joystick.h"
+#include "os_scheduler.h"
+#include "util.h"
+#include <avr/interrupt.h>
 #include <avr/io.h>
+#include <util/atomic.h>
 
-void js_init(void){
-	DDRA &= ~((1<<PA5)|(1<<PA6)|(1<<PA7)); //eingang
-	PORTA |= (1<<PA7); // Aktiviere pullup widerstand
-	ADMUX = (1<<REFS0); // VCC referenzspannung
-	ADCSRA = (1<<ADEN) | (1<<ADPS2)|(1<<ADPS1)|(1<<ADPS0); // ADC aktivieren und aud 128 setzen
+/*
+ * Der ADC misst ohne Zutun der Prozesse: jeder Überlauf von Timer 0 (alle
+ * 3,3 ms, der Timer läuft für die Systemzeit sowieso) startet eine Wandlung,
+ * abwechselnd auf ADC5 und ADC6. Die ISR legt ein fertiges Paar in einen
+ * Doppelpuffer, so passen horizontaler und vertikaler Wert immer zusammen.
+ */
+
+#if (JS_EVENT_QUEUE_SIZE & (JS_EVENT_QUEUE_SIZE - 1)) || JS_EVENT_QUEUE_SIZE > 128
+#error "JS_EVENT_QUEUE_SIZE muss eine Zweierpotenz bis 128 sein"
+#endif
+
+#define JS_CHANNEL_HORIZONTAL ((1 << MUX2) | (1 << MUX0)) // ADC5
+#define JS_CHANNEL_VERTICAL ((1 << MUX2) | (1 << MUX1))   // ADC6
+
+// Doppelpuffer: [Puffer][0 = horizontal, 1 = vertikal]
+static volatile uint16_t samples[2][2];
+// Puffer mit dem letzten vollständigen Paar
+static volatile uint8_t readBuffer = 0;
+static volatile bool sampled = false;
+
+// Entprellung
+static Direction stableDirection = JS_NEUTRAL;
+static Direction candidateDirection = JS_NEUTRAL;
+static uint8_t candidateCount = 0;
+
+// Ereignisliste, count zählt alle je eingetragenen Ereignisse
+static volatile Direction events[JS_EVENT_QUEUE_SIZE];
+static volatile uint8_t eventCount = 0;
+
+
+static Direction js_toDirection(uint16_t h, uint16_t v){
+	const uint16_t mid = 512;
+	const uint16_t tol = 204;  //(1V / 5V) * 1024 = 204
+	if(h < mid - tol) return JS_LEFT;
+	if(h > mid + tol) return JS_RIGHT;
+	if(v < mid - tol) return JS_DOWN;
+	if(v > mid + tol) return JS_UP;
+	return JS_NEUTRAL;
 }
 
 
+// neue Richtung erst nach JS_DEBOUNCE_SAMPLES gleichen Paaren übernehmen
+static void js_debounce(Direction direction){
+	if (direction != candidateDirection){
+		candidateDirection = direction;
+		candidateCount = 0;
+	}
+	if (candidateCount < JS_DEBOUNCE_SAMPLES){
+		candidateCount++;
+	}
+	if (candidateCount == JS_DEBOUNCE_SAMPLES && direction != stableDirection){
+		stableDirection = direction;
+		events[eventCount % JS_EVENT_QUEUE_SIZE] = direction;
+		eventCount++;
+	}
+}
 
-uint16_t js_getHorizontal(void){
-	// Auswahl des ADC-Kanals
-	ADMUX = (ADMUX & 0xF0) | (1 << MUX2) | (1 << MUX0); // Kanal ADC5
 
-	// messenstarten
-	ADCSRA |= (1 << ADSC);
+ISR(ADC_vect){
+	const uint16_t value = ADC;
+	const uint8_t write = readBuffer ^ 1;
+	if ((ADMUX & 0x0F) == JS_CHANNEL_HORIZONTAL){
+		samples[write][0] = value;
+		ADMUX = (ADMUX & 0xF0) | JS_CHANNEL_VERTICAL;
+	} else {
+		samples[write][1] = value;
+		readBuffer = write;
+		sampled = true;
+		ADMUX = (ADMUX & 0xF0) | JS_CHANNEL_HORIZONTAL;
+		js_debounce(js_toDirection(samples[write][0], value));
+	}
+}
 
-	// warte bis fertig
-	while (ADCSRA & (1 << ADSC));
 
-	
-	return ADC;
+void js_init(void){
+	DDRA &= ~((1<<PA5)|(1<<PA6)|(1<<PA7)); //eingang
+	PORTA |= (1<<PA7); // Aktiviere pullup widerstand
+	ADMUX = (1<<REFS0) | JS_CHANNEL_HORIZONTAL; // VCC referenzspannung
+	ADCSRB = (1<<ADTS2); // Start bei Überlauf von Timer 0
+	sampled = false;
+	ADCSRA = (1<<ADEN) | (1<<ADATE) | (1<<ADIE) | (1<<ADPS2)|(1<<ADPS1)|(1<<ADPS0); // ADC aktivieren und aud 128 setzen
+
+	// auf das erste Paar warten, damit js_getDirection gleich gültige Werte liefert
+	while (!sampled){
+	}
 }
 
-uint16_t js_getVertical(void){
-	
-	ADMUX = (ADMUX & 0xF0) | (1 << MUX2) | (1 << MUX1); // Kanal ADC6
 
-	
-	ADCSRA |= (1 << ADSC);
 
-	
-	while (ADCSRA & (1 << ADSC));
+uint16_t js_getHorizontal(void){
+	uint16_t value;
+	ATOMIC {
+		value = samples[readBuffer][0];
+	}
+	return value;
+}
 
-	
-	return ADC;
+uint16_t js_getVertical(void){
+	uint16_t value;
+	ATOMIC {
+		value = samples[readBuffer][1];
+	}
+	return value;
 }
 
 Direction js_getDirection(void){
-	uint16_t h = js_getHorizontal();
-	uint16_t v = js_getVertical();
-	const uint16_t mid = 512;
-	const uint16_t tol = 204;  //(1V / 5V) * 1024 = 204
-	if(h < mid - tol) return JS_LEFT;
-	if(h > mid + tol) return JS_RIGHT;
-	if(v < mid - tol) return JS_DOWN;
-	if(v > mid + tol) return JS_UP;
-	return JS_NEUTRAL;
+	uint16_t h, v;
+	// beide Werte aus demselben Paar
+	ATOMIC {
+		h = samples[readBuffer][0];
+		v = samples[readBuffer][1];
+	}
+	return js_toDirection(h, v);
 }
 
 bool js_getButton(void){
@@ -62,13 +132,43 @@ bool js_getButton(void){
 
 
 
+void js_openEvents(JsEventReader *reader){
+	reader->next = eventCount;
+}
 
 
+bool js_nextEvent(JsEventReader *reader, Direction *direction){
+	bool available = false;
+	ATOMIC {
+		const uint8_t count = eventCount;
+		if (reader->next != count){
+			// zu weit zurück: die ältesten Ereignisse sind schon überschrieben
+			if ((uint8_t)(count - reader->next) > JS_EVENT_QUEUE_SIZE){
+				reader->next = count - JS_EVENT_QUEUE_SIZE;
+			}
+			*direction = events[reader->next % JS_EVENT_QUEUE_SIZE];
+			reader->next++;
+			available = true;
+		}
+	}
+	return available;
+}
+
+
+Direction js_waitForEvent(JsEventReader *reader){
+	Direction direction;
+	while (!js_nextEvent(reader, &direction)){
+		os_yield();
+	}
+	return direction;
+}
+
 
 
 
 void os_waitForJoystickButtonInput(){
 	while (!js_getButton()){
+		os_yield();
 	}
 }
 
@@ -77,5 +177,6 @@ void os_waitForJoystickButtonInput(){
 
 void os_waitForNoJoystickButtonInput(){
 	while (js_getButton()){
+		os_yield();
 	}
-}
\ No newline at end of file
+}
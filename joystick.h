@@ -20,6 +20,17 @@ typedef enum {
 	JS_NEUTRAL
 } Direction;
 
+// Anzahl gleicher Messpaare, bevor eine neue Richtung gilt (ein Paar alle ~6,5 ms)
+#define JS_DEBOUNCE_SAMPLES 3
+
+// Größe der Ereignisliste, muss eine Zweierpotenz sein
+#define JS_EVENT_QUEUE_SIZE 4
+
+// Lesezeiger eines Prozesses in die Ereignisliste, jeder Leser bekommt alle Ereignisse
+typedef struct {
+	uint8_t next;
+} JsEventReader;
+
 void js_init(void);
 uint16_t js_getHorizontal(void);
 uint16_t js_getVertical(void);
@@ -29,4 +40,13 @@ void os_waitForJoystickButtonInput(void);
 
 void os_waitForNoJoystickButtonInput(void);
 
+// Ab jetzt neue Richtungswechsel lesen
+void js_openEvents(JsEventReader *reader);
+
+// Nächster entprellter Richtungswechsel, false wenn keiner vorliegt
+bool js_nextEvent(JsEventReader *reader, Direction *direction);
+
+// Wartet (ohne Rechenzeit zu verbrauchen) auf den nächsten Richtungswechsel
+Direction js_waitForEvent(JsEventReader *reader);
+
 #endif 
\ No newline at end of file
@@ -12,6 +12,7 @@
 #ifdef VERSUCH
 #include "util.h"
 #endif
+#include "os_spi.h"
 
 #pragma GCC push_options
 #pragma GCC optimize("O3")
@@ -30,6 +31,24 @@
  */
 uint8_t charCtr;
 
+//! Shadow of the 32 cells (after remapping to the LCD charset). Between
+//! lcd_beginFrame and lcd_present it is the back buffer and the cells that
+//! differ from the LCD are marked in changedCells.
+static char screen[32];
+static uint32_t changedCells;
+static bool framing = false;
+
+//! Cell the LCD cursor was at when the frame began
+static uint8_t frameCursor;
+
+//! Marks a cursor position that is no cell, e.g. the address after the end of line 1
+#define LCD_NO_CELL 0xFF
+
+//! Nibble pairs waiting to be sent by the timer 0 compare ISR
+static uint8_t queue[LCD_QUEUE_SIZE][2];
+static volatile uint8_t queueHead = 0;
+static volatile uint8_t queueTail = 0;
+
 /*!
  *  Internally used to turn on LCD Pin EN (Enable) for 1us.
  *  \internal
@@ -91,16 +110,20 @@ void lcd_init(void) {
  *  Moves the cursor to the first character of the first line of the LCD.
  */
 void lcd_line1(void) {
-    lcd_command(LCD_LINE_1);
     charCtr = 0;
+    if (!framing) {
+        lcd_command(LCD_LINE_1);
+    }
 }
 
 /*!
  *  Moves the cursor to the first character of the second line of the LCD.
  */
 void lcd_line2(void) {
-    lcd_command(LCD_LINE_2);
     charCtr = 16;
+    if (!framing) {
+        lcd_command(LCD_LINE_2);
+    }
 }
 
 /*!
@@ -157,7 +180,91 @@ void lcd_goto(unsigned char row, unsigned char column) {
     // Update char counter
     charCtr = row * 16 + column;
 
-    lcd_command(command);
+    if (!framing) {
+        lcd_command(command);
+    }
+}
+
+/*!
+ *  Puts a nibble pair on the port. The busy flag is not read, the caller
+ *  makes sure the LCD had enough time for the previous one. Afterwards RS
+ *  is left high, because PB4 is also the chip select of the external SRAM.
+ *  \internal
+ */
+static void lcd_transmit(uint8_t firstByte, uint8_t secondByte) {
+    LCD_PORT_DATA = firstByte;
+    lcd_enable();
+    LCD_PORT_DATA = secondByte;
+    lcd_enable();
+    sbi(LCD_PORT_DATA, LCD_RS_PIN);
+}
+
+//! Clear and return home need a lot longer than all other commands
+static bool lcd_isSlowCommand(uint8_t firstByte, uint8_t secondByte) {
+    return firstByte == 0 && secondByte <= (LCD_CURSOR_START & 0xF);
+}
+
+//! Sends a pair and waits until the LCD executed it
+static void lcd_transmitAndWait(uint8_t firstByte, uint8_t secondByte) {
+    lcd_transmit(firstByte, secondByte);
+    if (lcd_isSlowCommand(firstByte, secondByte)) {
+        _delay_ms(LCD_SLOW_DELAY_MS);
+    } else {
+        _delay_us(LCD_FAST_DELAY_US);
+    }
+}
+
+/*!
+ *  Sends the next queued nibble pair and schedules the next compare match
+ *  when the LCD has executed it. Timer 0 runs freely for the system time,
+ *  so the compare unit can be moved around without disturbing it.
+ */
+ISR(TIMER0_COMPA_vect) {
+    if (queueTail == queueHead) {
+        cbi(TIMSK0, OCIE0A);
+        return;
+    }
+    // An SPI transfer is running (chip select low or queued), try again later
+    if (!gbi(LCD_PORT_DATA, LCD_RS_PIN) || os_spi_isBusy()) {
+        OCR0A = TCNT0 + LCD_FAST_TICKS;
+        return;
+    }
+    const uint8_t *pair = queue[queueTail];
+    lcd_transmit(pair[0], pair[1]);
+    OCR0A = TCNT0 + (lcd_isSlowCommand(pair[0], pair[1]) ? LCD_SLOW_TICKS : LCD_FAST_TICKS);
+    queueTail = (queueTail + 1) % LCD_QUEUE_SIZE;
+}
+
+/*!
+ *  Sends everything in the queue and then the given pair right away. Used
+ *  when interrupts are disabled (during the boot, in the scheduler ISR or on
+ *  an error screen), where the queue would never be drained otherwise.
+ *  \internal
+ */
+static void lcd_sendNow(uint8_t firstByte, uint8_t secondByte) {
+    // The ISR is idle once it found the queue empty, which is after the delay of its last pair
+    if (gbi(TIMSK0, OCIE0A)) {
+        cbi(TIMSK0, OCIE0A);
+        _delay_ms(LCD_SLOW_DELAY_MS);
+    }
+    while (queueTail != queueHead) {
+        const uint8_t *pair = queue[queueTail];
+        lcd_transmitAndWait(pair[0], pair[1]);
+        queueTail = (queueTail + 1) % LCD_QUEUE_SIZE;
+    }
+    lcd_transmitAndWait(firstByte, secondByte);
+}
+
+//! Appends a pair to the queue, the caller has disabled interrupts
+static bool lcd_enqueue(uint8_t firstByte, uint8_t secondByte) {
+    const uint8_t next = (queueHead + 1) % LCD_QUEUE_SIZE;
+    if (next == queueTail) {
+        return false;
+    }
+    queue[queueHead][0] = firstByte;
+    queue[queueHead][1] = secondByte;
+    queueHead = next;
+    return true;
 }
 
 /*!
@@ -165,67 +272,29 @@ void lcd_goto(unsigned char row, unsigned char column) {
  *  holds a command or a printable char.
  *  This function is used by lcd_command and lcd_writeChar.
  *
+ *  With interrupts enabled the pair is only queued and sent by the timer 0
+ *  compare ISR. The caller only waits if the queue is full, until the ISR
+ *  has sent one pair (about 50 us).
+ *
  *  \param firstByte The first value to send.
  *  \param secondByte The second value to send.
  */
 void lcd_sendStream(uint8_t firstByte, uint8_t secondByte) {
-    // Check if interrupts are set and store that state
-    uint8_t sreg = SREG & (1 << 7);
-
-    // Interrupts off
-    cli();
-    uint16_t iterations = 0;
-    bool busy = false;
-
-    // Wait while LCD is busy or timeout was reached
-    do {
-        // Read busy flag state:
-        // Set R/W port to high, all others to low
-        LCD_PORT_DATA = 0x40;
-
-        // Set enable port to high to read first nibble
-        sbi(LCD_PORT_DATA, 5);
-
-        // Enable reading from pins 1 to 4
-        LCD_PORT_DDR = 0xF0;
-
-        // Set pull-ups
-        LCD_PORT_DATA |= 0x0F;
-
-        // Read busy flag (port 4) and store state to 'busy'
-        busy = LCD_PIN & 0x08;
-
-        // Set enable port back to low
-        cbi(LCD_PORT_DATA, 5);
-
-        // Second nibble is not used, waste it by calling lcd_enable
-        lcd_enable();
-
-        // Increase count of iterations
-        iterations++;
-        if (iterations == LCD_BUSY_TIMEOUT) {
-            // Timeout: Try to reset LCD
-            lcd_enable();
-
-            // Restore interrupt flag
-            SREG |= sreg;
-            return;
+    if (!gbi(SREG, 7)) {
+        lcd_sendNow(firstByte, secondByte);
+        return;
+    }
+    bool queued = false;
+    while (!queued) {
+        ATOMIC {
+            queued = lcd_enqueue(firstByte, secondByte);
+            if (!gbi(TIMSK0, OCIE0A)) {
+                OCR0A = TCNT0 + 1;
+                TIFR0 = (1 << OCF0A);
+                sbi(TIMSK0, OCIE0A);
+            }
         }
-    } while (busy);
-
-    // Transmit command:
-    LCD_PORT_DDR = 0xFF;
-
-    // Send first Byte
-    LCD_PORT_DATA = firstByte;
-    lcd_enable();
-
-    // Send second Byte
-    LCD_PORT_DATA = secondByte;
-    lcd_enable();
-
-    // Restore interrupt flag
-    SREG |= sreg;
+    }
 }
 
 /*!
@@ -250,6 +319,109 @@ void lcd_writeWChar(uint16_t character) {
     lcd_writeChar(character);
 }
 
+//! A remapping from a UTF-8 code point (its bytes, big endian) to the LCD charset
+typedef struct {
+    uint32_t utf8;
+    uint8_t lcd;
+} LcdRemap;
+
+//! The only ASCII characters the LCD ROM has other glyphs for (yen sign and right arrow)
+#define LCD_ASCII_BACKSLASH 0x5C
+#define LCD_ASCII_TILDE 0x7E
+
+//! Sorted by code point for the binary search in lcd_remap
+static const LcdRemap remaps[] PROGMEM = {
+    {LCD_ASCII_BACKSLASH, LCD_CC_BACKSLASH},  // '\'
+    {LCD_ASCII_TILDE, LCD_CC_TILDE},          // ~
+    {0xC2A5, 0x5C},            // ¥
+    {0xC2B0, 0xDF},            // °
+    {0xC2B5, 0xE4},            // µ
+    {0xC384, 0xE1},            // Ä
+    {0xC396, 0xEF},            // Ö
+    {0xC39C, 0xF5},            // Ü
+    {0xC39F, 0xE2},            // ß
+    {0xC3A4, 0xE1},            // ä
+    {0xC3B6, 0xEF},            // ö
+    {0xC3B7, 0xFD},            // ÷
+    {0xC3BC, 0xF5},            // ü
+    {0xCEA3, 0xF6},            // Σ
+    {0xCEA9, 0xF4},            // Ω
+    {0xCEB1, 0xE0},            // α
+    {0xCEB5, 0xE3},            // ε
+    {0xCEBC, LCD_CC_MU},       // μ
+    {0xCF80, 0xF7},            // π
+    {0xCF81, 0xE6},            // ρ
+    {0xCF83, 0xE5},            // σ
+    {0xE285BA, LCD_CC_IXI},    // ⅺ
+    {0xE28690, 0x7F},          // ←
+    {0xE28692, 0x7E},          // →
+    {0xE2889A, 0xE8},          // √
+    {0xE296A1, 0xDB},          // □
+    {0xE296AE, 0xFF},          // ▮
+};
+
+//! Number of entries of remaps
+#define LCD_REMAP_COUNT (sizeof(remaps) / sizeof(remaps[0]))
+
+//! State of the UTF-8 decoder, a code point may be split over several calls
+static uint32_t codePoint = 0;
+static uint8_t expectedBytes = 0;
+
+/*!
+ *  Looks up a code point in the remap table (at most 5 steps).
+ *
+ *  \param utf8 The code point.
+ *  \param fallback The char to write if it is not in the table.
+ *  \return The char in the LCD charset.
+ *  \internal
+ */
+static char lcd_remap(uint32_t utf8, char fallback) {
+    uint8_t low = 0;
+    uint8_t high = LCD_REMAP_COUNT;
+    while (low < high) {
+        const uint8_t middle = (low + high) / 2;
+        const uint32_t key = pgm_read_dword(&remaps[middle].utf8);
+        if (key == utf8) {
+            return pgm_read_byte(&remaps[middle].lcd);
+        } else if (key < utf8) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return utf8 <= 0x7F ? utf8 : fallback;
+}
+
+//! Whether a char is printed as it is, i.e. printable ASCII that is not in remaps[]
+static bool lcd_isPlain(char character) {
+    return character >= ' ' && character < LCD_ASCII_TILDE && character != LCD_ASCII_BACKSLASH;
+}
+
+/*!
+ *  Writes a char of the LCD charset at the cursor and advances the cursor,
+ *  the line is changed first if the cursor is behind the end of a line.
+ *  \internal
+ */
+static void lcd_writeCell(char character) {
+    if (charCtr == 0x10) {
+        lcd_line2();
+    } else if (charCtr == 0x20) {
+        lcd_clear();
+        lcd_line1();
+    }
+
+    // Update char counter ... Do not modulo it down! we need it to become 32
+    if (framing) {
+        if (screen[charCtr] != character) {
+            changedCells |= 1ul << charCtr;
+        }
+        screen[charCtr++] = character;
+        return;
+    }
+    screen[charCtr++] = character;
+    lcd_sendStream(0x10 | ((character & 0xF0) >> 4), 0x10 | (character & 0x0F));
+}
+
 /*!
  *  Writes an 8-Bit UTF-8-like-value to the LCD.
  *  Supports automatic line breaks.
@@ -257,92 +429,46 @@ void lcd_writeWChar(uint16_t character) {
  *  \param character  The character to be written.
  */
 void lcd_writeChar(char character) {
-    ATOMIC { // Turn of interrupts
-
-        // For UTF-8 multibyte code point
-        static uint32_t codePoint = 0;
-        static uint8_t expectedBytes = 0;
-
-        // Handle UTF-8
-        if (!expectedBytes) { // New code point
-            codePoint = character;
-            if (character <= 0x7F)
-                expectedBytes = 0;        // 1 byte code points
-            else if (character <= 0xBF) { // No more continuation byte expected
-                codePoint = 0xE296A1;
-                expectedBytes = 0;
-            } else if (character <= 0xDF)
-                expectedBytes = 1; // 2 byte code points
-            else if (character <= 0xEF)
-                expectedBytes = 2; // 3 byte code points
-            else if (character <= 0xFF)
-                expectedBytes = 3;                        // 4 byte code points
-        } else {                                          // Continuation byte expected
-            if (0x80 <= character && character <= 0xBF) { // Continuation byte
-                codePoint = (codePoint << 8) | character;
-                expectedBytes--;
-            } else { // No new code point expected
-                codePoint = 0xE296A1;
-                expectedBytes = 0;
-            }
+    // Handle UTF-8
+    if (!expectedBytes) { // New code point
+        codePoint = character;
+        if (character <= 0x7F)
+            expectedBytes = 0;        // 1 byte code points
+        else if (character <= 0xBF) { // No more continuation byte expected
+            codePoint = 0xE296A1;
+            expectedBytes = 0;
+        } else if (character <= 0xDF)
+            expectedBytes = 1; // 2 byte code points
+        else if (character <= 0xEF)
+            expectedBytes = 2; // 3 byte code points
+        else if (character <= 0xFF)
+            expectedBytes = 3;                        // 4 byte code points
+    } else {                                          // Continuation byte expected
+        if (0x80 <= character && character <= 0xBF) { // Continuation byte
+            codePoint = (codePoint << 8) | character;
+            expectedBytes--;
+        } else { // No new code point expected
+            codePoint = 0xE296A1;
+            expectedBytes = 0;
         }
+    }
 
-        // Don't print UTF-8 special bytes
-        if (expectedBytes) return;
+    // Don't print UTF-8 special bytes
+    if (expectedBytes) return;
 
-        // Check if line shall be changed
-        if (codePoint == '\n') {
-            charCtr = charCtr < 0x10 ? 0x10 : 0x20;
-        }
+    // Check if line shall be changed
+    if (codePoint == '\n') {
+        charCtr = charCtr < 0x10 ? 0x10 : 0x20;
         if (charCtr == 0x10) {
             lcd_line2();
-        } else if (charCtr == 0x20) {
+        } else {
             lcd_clear();
             lcd_line1();
         }
-
-        if (codePoint == '\n') return;
-
-// A remapping from UTF-8 to LCD
-#define REMAP(UTF8, LCD) \
-    case UTF8: character = LCD; break
-        switch (codePoint) {
-            REMAP(0x5C, LCD_CC_BACKSLASH); // '\'
-            REMAP(0x7E, LCD_CC_TILDE);     // ~
-            REMAP(0xC2A5, 0x5C);           // ¥
-            REMAP(0xC2B0, 0xDF);           // °
-            REMAP(0xC2B5, 0xE4);           // µ
-            REMAP(0xC384, 0xE1);           // Ä
-            REMAP(0xC396, 0xEF);           // Ö
-            REMAP(0xC39C, 0xF5);           // Ü
-            REMAP(0xC39F, 0xE2);           // ß
-            REMAP(0xC3A4, 0xE1);           // ä
-            REMAP(0xC3B6, 0xEF);           // ö
-            REMAP(0xC3B7, 0xFD);           // ÷
-            REMAP(0xC3BC, 0xF5);           // ü
-            REMAP(0xCEA3, 0xF6);           // Σ
-            REMAP(0xCEA9, 0xF4);           // Ω
-            REMAP(0xCEB1, 0xE0);           // α
-            REMAP(0xCEB5, 0xE3);           // ε
-            REMAP(0xCEBC, LCD_CC_MU);      // μ
-            REMAP(0xCF80, 0xF7);           // π
-            REMAP(0xCF81, 0xE6);           // ρ
-            REMAP(0xCF83, 0xE5);           // σ
-            REMAP(0xE285BA, LCD_CC_IXI);   // ⅺ
-            REMAP(0xE28690, 0x7F);         // ←
-            REMAP(0xE28692, 0x7E);         // →
-            REMAP(0xE2889A, 0xE8);         // √
-            REMAP(0xE296A1, 0xDB);         // □
-            REMAP(0xE296AE, 0xFF);         // ▮
-            default: character = codePoint <= 0x7F ? codePoint : character; break;
-        }
-#undef REMAP
-
-        lcd_sendStream(0x10 | ((character & 0xF0) >> 4), 0x10 | (character & 0x0F));
-
-        // Update char counter ... Do not modulo it down! we need it to become 32
-        charCtr++;
+        return;
     }
+
+    lcd_writeCell(lcd_remap(codePoint, character));
 }
 
 /*!
@@ -350,9 +476,78 @@ void lcd_writeChar(char character) {
  */
 void lcd_clear(void) {
     charCtr = 0;
+    if (framing) {
+        for (uint8_t i = 0; i < 32; i++) {
+            if (screen[i] != ' ') {
+                changedCells |= 1ul << i;
+            }
+            screen[i] = ' ';
+        }
+        return;
+    }
+    for (uint8_t i = 0; i < 32; i++) {
+        screen[i] = ' ';
+    }
     lcd_command(LCD_CLEAR);
 }
 
+/*!
+ *  Starts a frame: until lcd_present, all output (including lcd_clear and
+ *  cursor movements) only changes the shadow buffer and marks the cells
+ *  that differ from the LCD, nothing is sent.
+ */
+void lcd_beginFrame(void) {
+    changedCells = 0;
+    // The LCD has no cursor on a cell after the end of a line (see lcd_writeChar)
+    frameCursor = (charCtr % 16 || charCtr == 0) ? charCtr : LCD_NO_CELL;
+    framing = true;
+}
+
+//! Sends the command that puts the LCD cursor onto a cell
+static void lcd_cursorTo(uint8_t cell) {
+    charCtr = cell;
+    lcd_command(LCD_CURSOR_MOVE_R + (cell % 16) + (cell / 16) * LCD_NEXT_ROW);
+}
+
+/*!
+ *  Ends the frame and sends only the cells that were marked as changed.
+ *  Runs of changed cells are written without moving the cursor in between,
+ *  as the LCD increments its address after every char. A single unchanged cell between two runs is written again,
+ *  which costs as much as the cursor command it saves. Finally the cursor
+ *  is put where the frame left it.
+ *
+ *  A taskman page that changes a few chars is sent in well below 1 ms
+ *  instead of the 3.7 ms of clearing and writing the whole display.
+ */
+void lcd_present(void) {
+    const uint8_t frameCtr = charCtr;
+    uint8_t cursor = frameCursor;
+    framing = false;
+
+    for (uint8_t i = 0; i < 32; i++) {
+        if (!(changedCells & (1ul << i))) {
+            continue;
+        }
+        if (cursor != i) {
+            if (cursor + 1 == i && i % 16) {
+                charCtr = i;
+                lcd_sendStream(0x10 | ((screen[cursor] & 0xF0) >> 4), 0x10 | (screen[cursor] & 0x0F));
+            } else {
+                lcd_cursorTo(i);
+            }
+        }
+        charCtr = i + 1;
+        lcd_sendStream(0x10 | ((screen[i] & 0xF0) >> 4), 0x10 | (screen[i] & 0x0F));
+        cursor = (i + 1) % 16 ? i + 1 : LCD_NO_CELL;
+    }
+
+    // Line changes at 16 and the clear at 32 are done by the next lcd_writeChar
+    charCtr = frameCtr;
+    if ((charCtr % 16 || charCtr == 0) && cursor != charCtr) {
+        lcd_cursorTo(charCtr);
+    }
+}
+
 /*!
  *  Erases one line of the LCD. Cursor will not be changed.
  *  \param line  the line which will be erased (may be 1 or 2).
@@ -474,7 +669,12 @@ void lcd_writeDec(uint16_t number) {
 void lcd_writeString(const char *text) {
     char c;
     while ((c = *text++)) {
-        lcd_writeChar(c);
+        // Plain ASCII needs neither decoding nor a lookup
+        if (!expectedBytes && lcd_isPlain(c)) {
+            lcd_writeCell(c);
+        } else {
+            lcd_writeChar(c);
+        }
     }
 }
 
@@ -510,7 +710,11 @@ void lcd_drawBar(uint8_t percent) {
 void lcd_writeProgString(const char *string) {
     char c;
     while ((c = (char)pgm_read_byte(string++))) {
-        lcd_writeChar(c);
+        if (!expectedBytes && lcd_isPlain(c)) {
+            lcd_writeCell(c);
+        } else {
+            lcd_writeChar(c);
+        }
     }
 }
 
@@ -532,19 +736,14 @@ void lcd_writeErrorProgString(const char *string) {
  *  \param chr The passed value is one 64 bit integer which holds all rows of the character.
  */
 void lcd_registerCustomChar(uint8_t addr, uint64_t chr) {
-    const uint8_t sreg = SREG & (1 << 7);
-    cli();
     lcd_command(0x40 | (0x38 & (addr << 3)));
-    _delay_us(40);
 
     uint8_t i = 8;
     while (i--) {
         const uint8_t row = chr & 0xFF;
         lcd_sendStream(((1 << LCD_RS_PIN) & 0xF0) | ((row >> 4) & 0xF), ((1 << LCD_RS_PIN) & 0xF0) | (row & 0xF));
-        _delay_us(40);
         chr >>= 8;
     }
-    SREG |= sreg;
 }
 
 /*!
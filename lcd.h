@@ -112,8 +112,16 @@
 
 #define LCD_EN_PIN 5
 
-//! Timeout for the busy signal of the LCD
-#define LCD_BUSY_TIMEOUT 2000
+//! Execution time of clear and return home and of all other commands
+#define LCD_SLOW_DELAY_MS 2
+#define LCD_FAST_DELAY_US 50
+
+//! The same times in ticks of timer 0 (12.8 us), which paces the output queue
+#define LCD_SLOW_TICKS 160
+#define LCD_FAST_TICKS 4
+
+//! Number of nibble pairs the output queue holds (2 bytes each), writers wait while it is full
+#define LCD_QUEUE_SIZE 8
 
 //----------------------------------------------------------------------------
 // Macros
@@ -216,6 +224,12 @@ void lcd_clear(void);
 //! Erases one line
 void lcd_erase(uint8_t line);
 
+//! Following output only goes to the shadow buffer
+void lcd_beginFrame(void);
+
+//! Sends the cells that changed since lcd_beginFrame
+void lcd_present(void);
+
 //! Write wide character
 void lcd_writeWChar(uint16_t character);
 
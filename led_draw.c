@@ -4,23 +4,65 @@
  */
 #include "led_draw.h"
 
+#include "led_font.h"
 #include "led_patterns.h"
 #include "util.h"
 #include "led_paneldriver.h"
 
+//! Number of draw_setPixel calls since the last draw_takeWriteCount
+static uint16_t pixelWrites = 0;
 
-#define NUM_PLANES 3
-#define NUM_DROWS 16
-#define NUM_COLS 32
-volatile uint8_t frameBuffer[NUM_PLANES][NUM_DROWS][NUM_COLS];
+/*!
+ *  Returns the number of pixels written since the last call and restarts
+ *  counting. Meant for measuring how much a renderer draws per step.
+ */
+uint16_t draw_takeWriteCount(void) {
+	const uint16_t count = pixelWrites;
+	pixelWrites = 0;
+	return count;
+}
+
+//! Set while a view (e.g. the heap map) has the panel for itself
+static bool panelLocked = false;
 
+//! Number of times the panel was unlocked, see draw_getUnlockCount
+static uint8_t panelUnlocks = 0;
+
+/*!
+ *  Reserves the panel: draw_setPixel and everything based on it ignore all
+ *  writes until it is unlocked, only draw_setPixelLocked still draws.
+ */
+void draw_lockPanel(bool locked) {
+	if (panelLocked && !locked) {
+		panelUnlocks++;
+	}
+	panelLocked = locked;
+}
+
+/*!
+ *  Counts how often a view gave the panel back. Whatever was drawn before
+ *  is gone then, so an owner that only draws what changed (like snake)
+ *  compares this with the value it saw last and redraws everything when
+ *  it differs.
+ */
+uint8_t draw_getUnlockCount(void) {
+	return panelUnlocks;
+}
 
 //! \brief Distributes bits of given color's channels r, g and b on layers of framebuffer
 void draw_setPixel(uint8_t x, uint8_t y, Color color) {
+	if (!panelLocked) {
+		draw_setPixelLocked(x, y, color);
+	}
+}
+
+//! \brief Like draw_setPixel, but also draws while the panel is locked
+void draw_setPixelLocked(uint8_t x, uint8_t y, Color color) {
 	 // Koordinaten berprfen
 	 if (x >= NUM_COLS || y >= NUM_DROWS * 2) {
 		 return; 
 	 }
+	 pixelWrites++;
 
 	 // suche ob untere oder obere hlfte
 	 bool lowerHalf = false;
@@ -64,6 +106,9 @@ void draw_setPixel(uint8_t x, uint8_t y, Color color) {
 			 if (color.b & mask) { *cell |= (1 << 5); }
 		 }
 	 }
+
+	 // Refresh ber die nderung informieren (Auto-Modus)
+	 panel_markDirty();
 	
 /* #error IMPLEMENT STH. HERE
     return; */
@@ -180,40 +225,97 @@ void draw_pattern(uint8_t x, uint8_t y, uint8_t height, uint8_t width, uint64_t
     }
 }
 
+/*! \brief Draws one vertical strip of a glyph
+ * \param x         Column of the strip
+ * \param y         Row of the top pixel
+ * \param height    Number of pixels in the strip
+ * \param strip     Bit i is the pixel in row y + i
+ * \param color     RGB color used for set pixels
+ * \param overwrite Delete pixels that are not set in the strip if set to true
+ */
+static void draw_strip(uint8_t x, uint8_t y, uint8_t height, uint8_t strip, Color color, bool overwrite) {
+    if (x >= NUM_COLS) {
+        return;
+    }
+    for (uint8_t i = 0; i < height; i++) {
+        if (strip & 1) {
+            draw_setPixel(x, y + i, color);
+        } else if (overwrite) {
+            draw_setPixel(x, y + i, COLOR_BLACK);
+        }
+        strip >>= 1;
+    }
+}
+
 /*! \brief Draws a character on the panel.
- * \param letter    A character of [0-9A-Za-z]. Note: small letters cannot be drawn, the corresponding capital letter will be drawn instead.
+ * \param letter    A character of the glyph atlas (see led_font.h). Note: small letters cannot be drawn, the corresponding capital letter will be drawn instead.
  * \param x         Column of left upper corner
  * \param y         Row of left upper corner
  * \param color     RGB color to draw letter with
  * \param overwrite Delete pixels in picture that are black in the pattern if set to true
+ * \param large     Draws large letters when set to true, otherwise small (small: 5x3 px, large: 7x5 px)
+ *
+ * The glyph is centered in a cell of fixed width, so letters drawn with a
+ * fixed distance stay aligned. Use draw_text for proportional text.
  */
 void draw_letter(char letter, uint8_t x, uint8_t y, Color color, bool overwrite, bool large) {
-    const uint64_t *pattern_table;
-    uint8_t idx;
-
-    // the type of character determines how we get our lookup table and index
-    if (letter >= '0' && letter <= '9') {
-        pattern_table = large ? led_large_numbers : led_small_numbers;
-        idx = letter - '0';
-    } else if (letter >= 'A' && letter <= 'Z') {
-        pattern_table = large ? led_large_letters : led_small_letters;
-        idx = letter - 'A';
+    const uint8_t *glyph = font_lookup(letter, large);
+    if (!glyph) {
+        return;
     }
 
-    else if (letter >= 'a' && letter <= 'z') {
-        pattern_table = large ? led_large_letters : led_small_letters;
-        idx = letter - 'a';
-    } else {
-        return;
+    const uint8_t cellWidth = large ? LED_CHAR_WIDTH_LARGE : LED_CHAR_WIDTH_SMALL;
+    const uint8_t height = large ? LED_CHAR_HEIGHT_LARGE : LED_CHAR_HEIGHT_SMALL;
+    const uint8_t width = pgm_read_byte(glyph++);
+    const uint8_t offset = (cellWidth - width) / 2;
+
+    for (uint8_t col = 0; col < cellWidth; col++) {
+        uint8_t strip = 0;
+        if (col >= offset && col < offset + width) {
+            strip = pgm_read_byte(glyph + col - offset);
+        }
+        draw_strip(x + col, y, height, strip, color, overwrite);
     }
+}
 
-    // in all cases, we have to fetch our pattern from a progmem array of patterns
-    // prepare a SRAM uint64_t value to store the pattern
-    uint64_t pattern;
+/*! \brief Draws a text with proportional glyphs on the panel
+ * \param text      Null terminated string, characters without a glyph are skipped
+ * \param x         Column of left upper corner
+ * \param y         Row of left upper corner
+ * \param color     RGB color to draw the text with
+ * \param overwrite Delete pixels (including the spacing between glyphs) that are black in the glyphs if set to true
+ * \param large     Draws large text when set to true, otherwise small (small: 5 px, large: 8 px high, see LED_CHAR_HEIGHT_SMALL/LARGE)
+ * \return The column right after the last drawn glyph
+ *
+ * Every glyph only advances by its own width plus LED_FONT_SPACING, so narrow
+ * characters like 'I', '1' or punctuation take less room than with draw_letter.
+ * Drawing stops as soon as the right edge of the panel has been reached.
+ */
+uint8_t draw_text(const char *text, uint8_t x, uint8_t y, Color color, bool overwrite, bool large) {
+    const uint8_t height = large ? LED_CHAR_HEIGHT_LARGE : LED_CHAR_HEIGHT_SMALL;
+    bool first = true;
+    char c;
+
+    while ((c = *text++) && x < NUM_COLS) {
+        const uint8_t *glyph = font_lookup(c, large);
+        if (!glyph) {
+            continue;
+        }
 
-    // Since there is no load function for uint64_ts, we will just use the Flash-to-SRAM version of memcpy
-    memcpy_P(&pattern, pattern_table + idx, sizeof(uint64_t));
-    draw_pattern(x, y, large ? LED_CHAR_HEIGHT_LARGE : LED_CHAR_HEIGHT_SMALL, large ? LED_CHAR_WIDTH_LARGE : LED_CHAR_WIDTH_SMALL, pattern, color, overwrite);
+        // kerning: the gap to the previous glyph
+        if (!first) {
+            for (uint8_t i = 0; i < LED_FONT_SPACING; i++, x++) {
+                draw_strip(x, y, height, 0, color, overwrite);
+            }
+        }
+        first = false;
+
+        const uint8_t width = pgm_read_byte(glyph++);
+        for (uint8_t col = 0; col < width; col++, x++) {
+            draw_strip(x, y, height, pgm_read_byte(glyph + col), color, overwrite);
+        }
+    }
+    return x;
 }
 
 
@@ -24,10 +24,20 @@ void draw_decimal(uint8_t dec, uint8_t x, uint8_t y, Color color, bool overwrite
 //! Draws capital letter on panel
 void draw_letter(char letter, uint8_t x, uint8_t y, Color color, bool overwrite, bool large);
 
+//! Draws a text with proportional glyphs on panel, returns the column after the text
+uint8_t draw_text(const char *text, uint8_t x, uint8_t y, Color color, bool overwrite, bool large);
+
 //! Draws an integer on panel
 void draw_number(uint32_t number, bool right_align, uint8_t x, uint8_t y, Color color, bool overwrite, bool large);
 
 void draw_setPixel(uint8_t x, uint8_t y, Color color);
+//! Reserves the panel for draw_setPixelLocked, other drawing is ignored while it is locked
+void draw_lockPanel(bool locked);
+//! Returns how often the panel was unlocked, owners redraw everything when it changes
+uint8_t draw_getUnlockCount(void);
+void draw_setPixelLocked(uint8_t x, uint8_t y, Color color);
+//! Returns and resets the number of pixels written by draw_setPixel
+uint16_t draw_takeWriteCount(void);
 Color draw_getPixel(uint8_t x, uint8_t y);
 void draw_fillPanel(Color color);
 void draw_clearDisplay();
@@ -0,0 +1,1249 @@
+/*! \file
+ *  \brief Glyph atlas for text output on the LED Panel
+ *
+ *  This is the glyph source of the panel font. Each glyph is written as its
+ *  width followed by its rows; LED_GLYPH_SMALL/LARGE turn it into column
+ *  strips at compile time, so nothing has to be decoded at runtime.
+ */
+
+#include "led_font.h"
+
+#include <avr/pgmspace.h>
+#include <stddef.h>
+#include <stdint.h>
+
+const uint8_t PROGMEM led_font_small[] = {
+    // ' '
+    LED_GLYPH_SMALL(
+        2,
+        0b00,
+        0b00,
+        0b00,
+        0b00,
+        0b00
+    ),
+    // '!'
+    LED_GLYPH_SMALL(
+        1,
+        0b1,
+        0b1,
+        0b1,
+        0b0,
+        0b1
+    ),
+    // '"'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b101,
+        0b000,
+        0b000,
+        0b000
+    ),
+    // '#'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b111,
+        0b101,
+        0b111,
+        0b101
+    ),
+    // '$'
+    LED_GLYPH_SMALL(
+        3,
+        0b011,
+        0b110,
+        0b010,
+        0b011,
+        0b110
+    ),
+    // '%'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b001,
+        0b010,
+        0b100,
+        0b101
+    ),
+    // '&'
+    LED_GLYPH_SMALL(
+        3,
+        0b010,
+        0b101,
+        0b010,
+        0b101,
+        0b011
+    ),
+    // '\''
+    LED_GLYPH_SMALL(
+        1,
+        0b1,
+        0b1,
+        0b0,
+        0b0,
+        0b0
+    ),
+    // '('
+    LED_GLYPH_SMALL(
+        2,
+        0b01,
+        0b10,
+        0b10,
+        0b10,
+        0b01
+    ),
+    // ')'
+    LED_GLYPH_SMALL(
+        2,
+        0b10,
+        0b01,
+        0b01,
+        0b01,
+        0b10
+    ),
+    // '*'
+    LED_GLYPH_SMALL(
+        3,
+        0b000,
+        0b101,
+        0b010,
+        0b101,
+        0b000
+    ),
+    // '+'
+    LED_GLYPH_SMALL(
+        3,
+        0b000,
+        0b010,
+        0b111,
+        0b010,
+        0b000
+    ),
+    // ','
+    LED_GLYPH_SMALL(
+        2,
+        0b00,
+        0b00,
+        0b00,
+        0b01,
+        0b10
+    ),
+    // '-'
+    LED_GLYPH_SMALL(
+        3,
+        0b000,
+        0b000,
+        0b111,
+        0b000,
+        0b000
+    ),
+    // '.'
+    LED_GLYPH_SMALL(
+        1,
+        0b0,
+        0b0,
+        0b0,
+        0b0,
+        0b1
+    ),
+    // '/'
+    LED_GLYPH_SMALL(
+        3,
+        0b001,
+        0b001,
+        0b010,
+        0b100,
+        0b100
+    ),
+    // '0'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b101,
+        0b101,
+        0b101,
+        0b111
+    ),
+    // '1'
+    LED_GLYPH_SMALL(
+        3,
+        0b001,
+        0b011,
+        0b101,
+        0b001,
+        0b001
+    ),
+    // '2'
+    LED_GLYPH_SMALL(
+        3,
+        0b110,
+        0b001,
+        0b010,
+        0b100,
+        0b111
+    ),
+    // '3'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b001,
+        0b111,
+        0b001,
+        0b111
+    ),
+    // '4'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b101,
+        0b111,
+        0b001,
+        0b001
+    ),
+    // '5'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b100,
+        0b111,
+        0b001,
+        0b111
+    ),
+    // '6'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b100,
+        0b111,
+        0b101,
+        0b111
+    ),
+    // '7'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b001,
+        0b001,
+        0b001,
+        0b001
+    ),
+    // '8'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b101,
+        0b111,
+        0b101,
+        0b111
+    ),
+    // '9'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b101,
+        0b111,
+        0b001,
+        0b111
+    ),
+    // ':'
+    LED_GLYPH_SMALL(
+        1,
+        0b0,
+        0b1,
+        0b0,
+        0b1,
+        0b0
+    ),
+    // ';'
+    LED_GLYPH_SMALL(
+        2,
+        0b00,
+        0b01,
+        0b00,
+        0b01,
+        0b10
+    ),
+    // '<'
+    LED_GLYPH_SMALL(
+        3,
+        0b001,
+        0b010,
+        0b100,
+        0b010,
+        0b001
+    ),
+    // '='
+    LED_GLYPH_SMALL(
+        3,
+        0b000,
+        0b111,
+        0b000,
+        0b111,
+        0b000
+    ),
+    // '>'
+    LED_GLYPH_SMALL(
+        3,
+        0b100,
+        0b010,
+        0b001,
+        0b010,
+        0b100
+    ),
+    // '?'
+    LED_GLYPH_SMALL(
+        3,
+        0b110,
+        0b001,
+        0b010,
+        0b000,
+        0b010
+    ),
+    // '@'
+    LED_GLYPH_SMALL(
+        3,
+        0b010,
+        0b101,
+        0b111,
+        0b100,
+        0b011
+    ),
+    // 'A'
+    LED_GLYPH_SMALL(
+        3,
+        0b010,
+        0b101,
+        0b111,
+        0b101,
+        0b101
+    ),
+    // 'B'
+    LED_GLYPH_SMALL(
+        3,
+        0b110,
+        0b101,
+        0b110,
+        0b101,
+        0b110
+    ),
+    // 'C'
+    LED_GLYPH_SMALL(
+        3,
+        0b011,
+        0b100,
+        0b100,
+        0b100,
+        0b011
+    ),
+    // 'D'
+    LED_GLYPH_SMALL(
+        3,
+        0b110,
+        0b101,
+        0b101,
+        0b101,
+        0b110
+    ),
+    // 'E'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b100,
+        0b111,
+        0b100,
+        0b111
+    ),
+    // 'F'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b100,
+        0b111,
+        0b100,
+        0b100
+    ),
+    // 'G'
+    LED_GLYPH_SMALL(
+        3,
+        0b011,
+        0b100,
+        0b101,
+        0b101,
+        0b011
+    ),
+    // 'H'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b101,
+        0b111,
+        0b101,
+        0b101
+    ),
+    // 'I'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b010,
+        0b010,
+        0b010,
+        0b111
+    ),
+    // 'J'
+    LED_GLYPH_SMALL(
+        3,
+        0b001,
+        0b001,
+        0b001,
+        0b101,
+        0b111
+    ),
+    // 'K'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b101,
+        0b110,
+        0b101,
+        0b101
+    ),
+    // 'L'
+    LED_GLYPH_SMALL(
+        3,
+        0b100,
+        0b100,
+        0b100,
+        0b100,
+        0b111
+    ),
+    // 'M'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b111,
+        0b101,
+        0b101,
+        0b101
+    ),
+    // 'N'
+    LED_GLYPH_SMALL(
+        3,
+        0b110,
+        0b101,
+        0b101,
+        0b101,
+        0b101
+    ),
+    // 'O'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b101,
+        0b101,
+        0b101,
+        0b111
+    ),
+    // 'P'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b101,
+        0b111,
+        0b100,
+        0b100
+    ),
+    // 'Q'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b101,
+        0b101,
+        0b111,
+        0b010
+    ),
+    // 'R'
+    LED_GLYPH_SMALL(
+        3,
+        0b110,
+        0b101,
+        0b110,
+        0b101,
+        0b101
+    ),
+    // 'S'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b100,
+        0b111,
+        0b001,
+        0b111
+    ),
+    // 'T'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b010,
+        0b010,
+        0b010,
+        0b010
+    ),
+    // 'U'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b101,
+        0b101,
+        0b101,
+        0b111
+    ),
+    // 'V'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b101,
+        0b101,
+        0b101,
+        0b010
+    ),
+    // 'W'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b101,
+        0b101,
+        0b111,
+        0b101
+    ),
+    // 'X'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b101,
+        0b010,
+        0b101,
+        0b101
+    ),
+    // 'Y'
+    LED_GLYPH_SMALL(
+        3,
+        0b101,
+        0b101,
+        0b010,
+        0b010,
+        0b010
+    ),
+    // 'Z'
+    LED_GLYPH_SMALL(
+        3,
+        0b111,
+        0b001,
+        0b010,
+        0b100,
+        0b111
+    ),
+};
+
+const uint8_t PROGMEM led_font_large[] = {
+    // ' '
+    LED_GLYPH_LARGE(
+        3,
+        0b000,
+        0b000,
+        0b000,
+        0b000,
+        0b000,
+        0b000,
+        0b000
+    ),
+    // '!'
+    LED_GLYPH_LARGE(
+        1,
+        0b1,
+        0b1,
+        0b1,
+        0b1,
+        0b1,
+        0b0,
+        0b1
+    ),
+    // '"'
+    LED_GLYPH_LARGE(
+        3,
+        0b101,
+        0b101,
+        0b101,
+        0b000,
+        0b000,
+        0b000,
+        0b000
+    ),
+    // '#'
+    LED_GLYPH_LARGE(
+        5,
+        0b01010,
+        0b01010,
+        0b11111,
+        0b01010,
+        0b11111,
+        0b01010,
+        0b01010
+    ),
+    // '$'
+    LED_GLYPH_LARGE(
+        5,
+        0b00100,
+        0b01111,
+        0b10100,
+        0b01110,
+        0b00101,
+        0b11110,
+        0b00100
+    ),
+    // '%'
+    LED_GLYPH_LARGE(
+        5,
+        0b11000,
+        0b11001,
+        0b00010,
+        0b00100,
+        0b01000,
+        0b10011,
+        0b00011
+    ),
+    // '&'
+    LED_GLYPH_LARGE(
+        5,
+        0b01100,
+        0b10010,
+        0b10100,
+        0b01000,
+        0b10101,
+        0b10010,
+        0b01101
+    ),
+    // '\''
+    LED_GLYPH_LARGE(
+        1,
+        0b1,
+        0b1,
+        0b1,
+        0b0,
+        0b0,
+        0b0,
+        0b0
+    ),
+    // '('
+    LED_GLYPH_LARGE(
+        3,
+        0b001,
+        0b010,
+        0b100,
+        0b100,
+        0b100,
+        0b010,
+        0b001
+    ),
+    // ')'
+    LED_GLYPH_LARGE(
+        3,
+        0b100,
+        0b010,
+        0b001,
+        0b001,
+        0b001,
+        0b010,
+        0b100
+    ),
+    // '*'
+    LED_GLYPH_LARGE(
+        5,
+        0b00000,
+        0b00100,
+        0b10101,
+        0b01110,
+        0b10101,
+        0b00100,
+        0b00000
+    ),
+    // '+'
+    LED_GLYPH_LARGE(
+        5,
+        0b00000,
+        0b00100,
+        0b00100,
+        0b11111,
+        0b00100,
+        0b00100,
+        0b00000
+    ),
+    // ','
+    LED_GLYPH_LARGE(
+        2,
+        0b00,
+        0b00,
+        0b00,
+        0b00,
+        0b01,
+        0b01,
+        0b10
+    ),
+    // '-'
+    LED_GLYPH_LARGE(
+        4,
+        0b0000,
+        0b0000,
+        0b0000,
+        0b1111,
+        0b0000,
+        0b0000,
+        0b0000
+    ),
+    // '.'
+    LED_GLYPH_LARGE(
+        2,
+        0b00,
+        0b00,
+        0b00,
+        0b00,
+        0b00,
+        0b11,
+        0b11
+    ),
+    // '/'
+    LED_GLYPH_LARGE(
+        5,
+        0b00000,
+        0b00001,
+        0b00010,
+        0b00100,
+        0b01000,
+        0b10000,
+        0b00000
+    ),
+    // '0'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b01110
+    ),
+    // '1'
+    LED_GLYPH_LARGE(
+        5,
+        0b01100,
+        0b10100,
+        0b00100,
+        0b00100,
+        0b00100,
+        0b00100,
+        0b01110
+    ),
+    // '2'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b00001,
+        0b00010,
+        0b00100,
+        0b01000,
+        0b11111
+    ),
+    // '3'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b00001,
+        0b00110,
+        0b00001,
+        0b10001,
+        0b01110
+    ),
+    // '4'
+    LED_GLYPH_LARGE(
+        5,
+        0b10000,
+        0b10100,
+        0b10100,
+        0b11111,
+        0b00100,
+        0b00100,
+        0b00100
+    ),
+    // '5'
+    LED_GLYPH_LARGE(
+        5,
+        0b11111,
+        0b10000,
+        0b11110,
+        0b00001,
+        0b00001,
+        0b10001,
+        0b01110
+    ),
+    // '6'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10000,
+        0b11110,
+        0b10001,
+        0b10001,
+        0b01110
+    ),
+    // '7'
+    LED_GLYPH_LARGE(
+        5,
+        0b11111,
+        0b10001,
+        0b00001,
+        0b00010,
+        0b00010,
+        0b00100,
+        0b00100
+    ),
+    // '8'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10001,
+        0b01110,
+        0b10001,
+        0b10001,
+        0b01110
+    ),
+    // '9'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10001,
+        0b01111,
+        0b00001,
+        0b10001,
+        0b01110
+    ),
+    // ':'
+    LED_GLYPH_LARGE(
+        2,
+        0b00,
+        0b11,
+        0b11,
+        0b00,
+        0b11,
+        0b11,
+        0b00
+    ),
+    // ';'
+    LED_GLYPH_LARGE(
+        2,
+        0b00,
+        0b11,
+        0b11,
+        0b00,
+        0b11,
+        0b01,
+        0b10
+    ),
+    // '<'
+    LED_GLYPH_LARGE(
+        4,
+        0b0001,
+        0b0010,
+        0b0100,
+        0b1000,
+        0b0100,
+        0b0010,
+        0b0001
+    ),
+    // '='
+    LED_GLYPH_LARGE(
+        4,
+        0b0000,
+        0b0000,
+        0b1111,
+        0b0000,
+        0b1111,
+        0b0000,
+        0b0000
+    ),
+    // '>'
+    LED_GLYPH_LARGE(
+        4,
+        0b1000,
+        0b0100,
+        0b0010,
+        0b0001,
+        0b0010,
+        0b0100,
+        0b1000
+    ),
+    // '?'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b00001,
+        0b00010,
+        0b00100,
+        0b00000,
+        0b00100
+    ),
+    // '@'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10111,
+        0b10101,
+        0b10111,
+        0b10000,
+        0b01110
+    ),
+    // 'A'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b11111,
+        0b10001,
+        0b10001
+    ),
+    // 'B'
+    LED_GLYPH_LARGE(
+        5,
+        0b11110,
+        0b10001,
+        0b10001,
+        0b11110,
+        0b10001,
+        0b10001,
+        0b11110
+    ),
+    // 'C'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10000,
+        0b10000,
+        0b10000,
+        0b10001,
+        0b01110
+    ),
+    // 'D'
+    LED_GLYPH_LARGE(
+        5,
+        0b11100,
+        0b10010,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10010,
+        0b11100
+    ),
+    // 'E'
+    LED_GLYPH_LARGE(
+        5,
+        0b11111,
+        0b10000,
+        0b10000,
+        0b11110,
+        0b10000,
+        0b10000,
+        0b11111
+    ),
+    // 'F'
+    LED_GLYPH_LARGE(
+        5,
+        0b11111,
+        0b10000,
+        0b10000,
+        0b11110,
+        0b10000,
+        0b10000,
+        0b10000
+    ),
+    // 'G'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10000,
+        0b10111,
+        0b10001,
+        0b10001,
+        0b01111
+    ),
+    // 'H'
+    LED_GLYPH_LARGE(
+        5,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b11111,
+        0b10001,
+        0b10001,
+        0b10001
+    ),
+    // 'I'
+    LED_GLYPH_LARGE(
+        3,
+        0b111,
+        0b010,
+        0b010,
+        0b010,
+        0b010,
+        0b010,
+        0b111
+    ),
+    // 'J'
+    LED_GLYPH_LARGE(
+        5,
+        0b00111,
+        0b00010,
+        0b00010,
+        0b00010,
+        0b00010,
+        0b10010,
+        0b01100
+    ),
+    // 'K'
+    LED_GLYPH_LARGE(
+        5,
+        0b10001,
+        0b10010,
+        0b10100,
+        0b11000,
+        0b10100,
+        0b10010,
+        0b10001
+    ),
+    // 'L'
+    LED_GLYPH_LARGE(
+        5,
+        0b10000,
+        0b10000,
+        0b10000,
+        0b10000,
+        0b10000,
+        0b10000,
+        0b11111
+    ),
+    // 'M'
+    LED_GLYPH_LARGE(
+        5,
+        0b10001,
+        0b11011,
+        0b10101,
+        0b10101,
+        0b10001,
+        0b10001,
+        0b10001
+    ),
+    // 'N'
+    LED_GLYPH_LARGE(
+        5,
+        0b10001,
+        0b10001,
+        0b11001,
+        0b10101,
+        0b10011,
+        0b10001,
+        0b10001
+    ),
+    // 'O'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b01110
+    ),
+    // 'P'
+    LED_GLYPH_LARGE(
+        5,
+        0b11110,
+        0b10001,
+        0b10001,
+        0b11110,
+        0b10000,
+        0b10000,
+        0b10000
+    ),
+    // 'Q'
+    LED_GLYPH_LARGE(
+        5,
+        0b01110,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10101,
+        0b10010,
+        0b01101
+    ),
+    // 'R'
+    LED_GLYPH_LARGE(
+        5,
+        0b11110,
+        0b10001,
+        0b10001,
+        0b11110,
+        0b10100,
+        0b10010,
+        0b10001
+    ),
+    // 'S'
+    LED_GLYPH_LARGE(
+        5,
+        0b01111,
+        0b10000,
+        0b10000,
+        0b01110,
+        0b00001,
+        0b00001,
+        0b11110
+    ),
+    // 'T'
+    LED_GLYPH_LARGE(
+        5,
+        0b11111,
+        0b00100,
+        0b00100,
+        0b00100,
+        0b00100,
+        0b00100,
+        0b00100
+    ),
+    // 'U'
+    LED_GLYPH_LARGE(
+        5,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b01110
+    ),
+    // 'V'
+    LED_GLYPH_LARGE(
+        5,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b01010,
+        0b00100
+    ),
+    // 'W'
+    LED_GLYPH_LARGE(
+        5,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b10101,
+        0b10101,
+        0b01010
+    ),
+    // 'X'
+    LED_GLYPH_LARGE(
+        5,
+        0b10001,
+        0b10001,
+        0b01010,
+        0b00100,
+        0b01010,
+        0b10001,
+        0b10001
+    ),
+    // 'Y'
+    LED_GLYPH_LARGE(
+        5,
+        0b10001,
+        0b10001,
+        0b10001,
+        0b01010,
+        0b00100,
+        0b00100,
+        0b00100
+    ),
+    // 'Z'
+    LED_GLYPH_LARGE(
+        5,
+        0b11111,
+        0b00001,
+        0b00010,
+        0b00100,
+        0b01000,
+        0b10000,
+        0b11111
+    ),
+};
+
+/*!
+ *  Looks up the glyph record of a character. Lower case letters share the
+ *  glyphs of the upper case ones.
+ *
+ *  \param character The character to look up.
+ *  \param large     Whether to use the large (7 rows) or the small (5 rows) atlas.
+ *  \return A pointer into program memory to the width byte of the record, NULL if
+ *          the character is not part of the atlas.
+ */
+const uint8_t *font_lookup(char character, bool large) {
+    if (character >= 'a' && character <= 'z') {
+        character -= 'a' - 'A';
+    }
+    if (character < LED_FONT_FIRST_CHAR || character > LED_FONT_LAST_CHAR) {
+        return NULL;
+    }
+    uint8_t idx = character - LED_FONT_FIRST_CHAR;
+    return large ? led_font_large + idx * LED_FONT_STRIDE_LARGE : led_font_small + idx * LED_FONT_STRIDE_SMALL;
+}
+
+/*!
+ *  \param character The character to look up.
+ *  \param large     Whether to use the large or the small atlas.
+ *  \return The width of the glyph in columns, 0 if the character has no glyph.
+ */
+uint8_t font_glyphWidth(char character, bool large) {
+    const uint8_t *glyph = font_lookup(character, large);
+    return glyph ? pgm_read_byte(glyph) : 0;
+}
+
+/*!
+ *  Calculates how many columns draw_text needs for a text. Characters that have
+ *  no glyph are skipped, just like draw_text does.
+ *
+ *  \param text  Null terminated string in SRAM.
+ *  \param large Whether to use the large or the small atlas.
+ *  \return The width in columns without trailing spacing.
+ */
+uint16_t font_textWidth(const char *text, bool large) {
+    uint16_t width = 0;
+    char c;
+    while ((c = *text++)) {
+        uint8_t glyphWidth = font_glyphWidth(c, large);
+        if (glyphWidth) {
+            width += glyphWidth + LED_FONT_SPACING;
+        }
+    }
+    return width ? width - LED_FONT_SPACING : 0;
+}
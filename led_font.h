@@ -0,0 +1,76 @@
+/*! \file
+ *  \brief Glyph atlas for text output on the LED Panel
+ *
+ *  Glyphs are written down row by row (like the patterns in led_patterns.h)
+ *  and converted at compile time into vertical bit strips, one byte per
+ *  column with bit 0 being the top row. Every glyph record starts with its
+ *  width, so text can be rendered proportionally.
+ */
+#ifndef _LED_FONT_H
+#define _LED_FONT_H
+#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+//! First character contained in the atlas
+#define LED_FONT_FIRST_CHAR ' '
+
+//! Last character contained in the atlas (lower case letters are mapped to upper case)
+#define LED_FONT_LAST_CHAR 'Z'
+
+//! Maximum glyph widths (the glyph heights are LED_CHAR_HEIGHT_SMALL/LARGE)
+#define LED_FONT_MAX_WIDTH_SMALL 3
+#define LED_FONT_MAX_WIDTH_LARGE 5
+
+//! Size of one glyph record in bytes: width followed by the column strips
+#define LED_FONT_STRIDE_SMALL (1 + LED_FONT_MAX_WIDTH_SMALL)
+#define LED_FONT_STRIDE_LARGE (1 + LED_FONT_MAX_WIDTH_LARGE)
+
+//! Number of empty columns between two glyphs of a text
+#define LED_FONT_SPACING 1
+
+//! Bit of row R that ends up in column COL of a glyph of width W (0 if COL lies outside the glyph)
+#define LED_GLYPH_BIT(W, COL, R) ((COL) < (W) ? (((R) >> (((W) + 7 - (COL)) & 7)) & 1) : 0)
+
+//! Vertical bit strip of column COL of a small (5 rows) glyph
+#define LED_GLYPH_STRIP_SMALL(W, COL, r0, r1, r2, r3, r4) \
+    (LED_GLYPH_BIT(W, COL, r0) << 0 | LED_GLYPH_BIT(W, COL, r1) << 1 | LED_GLYPH_BIT(W, COL, r2) << 2 | LED_GLYPH_BIT(W, COL, r3) << 3 | LED_GLYPH_BIT(W, COL, r4) << 4)
+
+//! Vertical bit strip of column COL of a large (7 rows) glyph
+#define LED_GLYPH_STRIP_LARGE(W, COL, r0, r1, r2, r3, r4, r5, r6)                                                                         \
+    (LED_GLYPH_BIT(W, COL, r0) << 0 | LED_GLYPH_BIT(W, COL, r1) << 1 | LED_GLYPH_BIT(W, COL, r2) << 2 | LED_GLYPH_BIT(W, COL, r3) << 3 | \
+     LED_GLYPH_BIT(W, COL, r4) << 4 | LED_GLYPH_BIT(W, COL, r5) << 5 | LED_GLYPH_BIT(W, COL, r6) << 6)
+
+/*!
+ *  Defines the record of a small glyph of width W. The rows are given as
+ *  integers of W bits, the most significant bit being the leftmost pixel.
+ */
+#define LED_GLYPH_SMALL(W, r0, r1, r2, r3, r4)          \
+    (W),                                                \
+    LED_GLYPH_STRIP_SMALL(W, 0, r0, r1, r2, r3, r4),    \
+    LED_GLYPH_STRIP_SMALL(W, 1, r0, r1, r2, r3, r4),    \
+    LED_GLYPH_STRIP_SMALL(W, 2, r0, r1, r2, r3, r4)
+
+//! Defines the record of a large glyph of width W, see LED_GLYPH_SMALL
+#define LED_GLYPH_LARGE(W, r0, r1, r2, r3, r4, r5, r6)          \
+    (W),                                                        \
+    LED_GLYPH_STRIP_LARGE(W, 0, r0, r1, r2, r3, r4, r5, r6),    \
+    LED_GLYPH_STRIP_LARGE(W, 1, r0, r1, r2, r3, r4, r5, r6),    \
+    LED_GLYPH_STRIP_LARGE(W, 2, r0, r1, r2, r3, r4, r5, r6),    \
+    LED_GLYPH_STRIP_LARGE(W, 3, r0, r1, r2, r3, r4, r5, r6),    \
+    LED_GLYPH_STRIP_LARGE(W, 4, r0, r1, r2, r3, r4, r5, r6)
+
+//! The glyph atlases, one record per character from LED_FONT_FIRST_CHAR to LED_FONT_LAST_CHAR
+extern const uint8_t PROGMEM led_font_small[];
+extern const uint8_t PROGMEM led_font_large[];
+
+//! Looks up the glyph record of a character (PROGMEM pointer) or NULL if it has none
+const uint8_t *font_lookup(char character, bool large);
+
+//! Width of the glyph of a character in columns (0 if it has none)
+uint8_t font_glyphWidth(char character, bool large);
+
+//! Width of a whole text in columns including the spacing between glyphs
+uint16_t font_textWidth(const char *text, bool large);
+
+#endif
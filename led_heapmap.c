@@ -0,0 +1,153 @@
+/*! \file
+ *  \brief Allocation map of a heap on the LED Panel
+ */
+#include "led_heapmap.h"
+
+#include "led_draw.h"
+#include "led_paneldriver.h"
+#include "os_memory.h"
+#include "os_scheduler.h"
+
+//! Number of pixels of the panel
+#define HEAPMAP_PIXELS ((uint16_t)NUM_COLS * NUM_DROWS * 2)
+
+//! Color of the pixels behind the end of the heap
+#define COLOR_HEAPMAP_OUTSIDE COLOR_DARKBLUE
+
+//! Heap that is shown, NULL if the view is closed
+static Heap const *shown = NULL;
+
+//! Bytes of the use area per pixel
+static uint16_t bytesPerPixel;
+
+//! \brief Color of an owner as it is stored at the start of a chunk
+static Color heapmap_color(uint8_t owner) {
+	switch (owner) {
+		case MEMORY_FREE: return COLOR_BLACK;
+		case 1: return COLOR_RED;
+		case 2: return COLOR_GREEN;
+		case 3: return COLOR_BLUE;
+		case 4: return COLOR_YELLOW;
+		case 5: return COLOR_PINK;
+		case 6: return COLOR_TURQUOISE;
+		case 7: return (Color){.r = 0xFF, .g = 0x80, .b = 0x00};
+		// MEMORY_SHARED_CLOSED bis MEMORY_SHARED_WRITE
+		default: return COLOR_WHITE;
+	}
+}
+
+static void heapmap_setPixel(uint16_t pixel, Color color) {
+	draw_setPixelLocked(pixel % NUM_COLS, pixel / NUM_COLS, color);
+}
+
+/*!
+ *  \return The first map entry in [from, to) that is not free (may be a
+ *          MEMORY_FOLLOWS), MEMORY_FREE if there is none.
+ */
+static uint8_t heapmap_firstUsed(Heap const *heap, MemAddr from, MemAddr to) {
+	for (MemAddr addr = from; addr < to; addr++) {
+		const uint8_t entry = os_getMapEntry(heap, addr);
+		if (entry != MEMORY_FREE) {
+			return entry;
+		}
+	}
+	return MEMORY_FREE;
+}
+
+/*!
+ *  Hook of os_memory, called within its critical section. Only the pixels
+ *  that cover the changed bytes are drawn, at most two of them (at the ends
+ *  of the range) need to read other map entries: in front of the range to
+ *  see whether the pixel keeps its color, behind a freed range to find the
+ *  next chunk (which starts there, as chunks are contiguous).
+ */
+static void heapmap_update(Heap const *heap, MemAddr addr, uint16_t length, uint8_t owner) {
+	if (heap != shown) {
+		return;
+	}
+	const MemAddr useStart = os_getUseStart(heap);
+	const uint16_t useSize = os_getUseSize(heap);
+	const uint16_t offset = addr - useStart;
+	const uint16_t firstPixel = offset / bytesPerPixel;
+	const uint16_t lastPixel = (offset + (length - 1)) / bytesPerPixel;
+	const MemAddr rangeEnd = addr + length;
+
+	for (uint16_t pixel = firstPixel; pixel <= lastPixel; pixel++) {
+		const MemAddr start = useStart + pixel * bytesPerPixel;
+		const uint16_t size = useSize - (start - useStart) < bytesPerPixel ? useSize - (start - useStart) : bytesPerPixel;
+		const MemAddr end = start + size;
+
+		// Ein belegtes Byte vor dem Bereich bestimmt die Farbe weiterhin
+		if (start < addr && heapmap_firstUsed(heap, start, addr) != MEMORY_FREE) {
+			continue;
+		}
+		if (owner != MEMORY_FREE) {
+			heapmap_setPixel(pixel, heapmap_color(owner));
+		} else {
+			heapmap_setPixel(pixel, heapmap_color(rangeEnd < end ? heapmap_firstUsed(heap, rangeEnd, end) : MEMORY_FREE));
+		}
+	}
+}
+
+/*!
+ *  Draws the whole map once, pixel by pixel in critical sections so no
+ *  allocation changes the entries of a pixel while they are read. The hook
+ *  is installed first: changes of pixels that are already drawn are applied
+ *  by it, the others are read in their new state.
+ *
+ *  \param heap The heap to show.
+ */
+void heapmap_show(Heap const *heap) {
+	os_setHeapHook(NULL);
+	draw_lockPanel(true);
+
+	const MemAddr useStart = os_getUseStart(heap);
+	const uint16_t useSize = os_getUseSize(heap);
+	bytesPerPixel = useSize / HEAPMAP_PIXELS + (useSize % HEAPMAP_PIXELS != 0);
+	if (!bytesPerPixel) {
+		bytesPerPixel = 1;
+	}
+	shown = heap;
+	os_setHeapHook(heapmap_update);
+
+	// Besitzer des Chunks, zu dem ein MEMORY_FOLLOWS gehört
+	uint8_t chunkOwner = MEMORY_FREE;
+	for (uint16_t pixel = 0; pixel < HEAPMAP_PIXELS; pixel++) {
+		const uint32_t offset = (uint32_t)pixel * bytesPerPixel;
+		if (offset >= useSize) {
+			heapmap_setPixel(pixel, COLOR_HEAPMAP_OUTSIDE);
+			continue;
+		}
+		uint8_t first = MEMORY_FREE;
+		os_enterCriticalSection();
+		for (uint16_t i = 0; i < bytesPerPixel && offset + i < useSize; i++) {
+			const uint8_t entry = os_getMapEntry(heap, useStart + offset + i);
+			if (entry != MEMORY_FOLLOWS && entry != MEMORY_SHARED_FOLLOWS) {
+				chunkOwner = entry;
+			}
+			if (first == MEMORY_FREE) {
+				first = chunkOwner;
+			}
+		}
+		heapmap_setPixel(pixel, heapmap_color(first));
+		os_leaveCriticalSection();
+	}
+}
+
+/*!
+ *  Clears the panel while it is still locked and unlocks it then, so the
+ *  owner (which redraws when draw_getUnlockCount changes) cannot draw
+ *  before the map is gone.
+ */
+void heapmap_hide(void) {
+	os_setHeapHook(NULL);
+	shown = NULL;
+	for (uint16_t pixel = 0; pixel < HEAPMAP_PIXELS; pixel++) {
+		heapmap_setPixel(pixel, COLOR_BLACK);
+	}
+	draw_lockPanel(false);
+}
+
+Heap const *heapmap_getHeap(void) {
+	return shown;
+}
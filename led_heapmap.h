@@ -0,0 +1,28 @@
+/*! \file
+ *  \brief Allocation map of a heap on the LED Panel
+ *
+ *  Every pixel stands for the same number of bytes of the use area, row by
+ *  row from the top left. A pixel shows the owner of the first allocated
+ *  byte it covers: a color per process, white for shared memory and black
+ *  if all of its bytes are free. Pixels behind the end of the heap are dark
+ *  blue.
+ *
+ *  The whole map is only read when the view is opened. After that, the
+ *  pixels are updated by the hook of os_memory for the bytes that changed.
+ */
+#ifndef _LED_HEAPMAP_H
+#define _LED_HEAPMAP_H
+#include "os_memheap_drivers.h"
+
+#include <stdbool.h>
+
+//! Shows the allocation map of a heap and keeps it up to date, the panel is locked meanwhile
+void heapmap_show(Heap const *heap);
+
+//! Closes the view, clears and unlocks the panel, the owner redraws (see draw_getUnlockCount)
+void heapmap_hide(void);
+
+//! Returns the heap that is shown, NULL if the view is closed
+Heap const *heapmap_getHeap(void);
+
+#endif
@@ -5,40 +5,97 @@
 #include "led_paneldriver.h"
 
 #include "defines.h"
+#include "os_scheduler.h"
 #include "util.h"
 
 #include <avr/interrupt.h>
 #include <stdbool.h>
+#include <util/atomic.h>
 #include <util/delay.h>
 
 
+//! Row address (within a half of the panel) that is shifted out next
+static uint8_t currentRow = 0;
+//! Bit of the plane that is shifted out next
+static uint8_t currentPlaneBit = 1;
+//! First column of the row that is shifted out next. The rows of all planes lie
+//! one after the other in frameBuffer, so the refresh just walks through it.
+//! The ISR cannot be interrupted by a writer, so volatile is not needed here.
+static const uint8_t *scanRow = (const uint8_t *)frameBuffer;
+
+//! Number of frame periods at the default refresh rate, used to pace animations
+static volatile uint16_t frameCount = 0;
+//! Timer ticks since the last increment of frameCount
+static uint16_t frameTicks = 0;
+
+//! Timer ticks per row at the refresh rate set by the user (applied at the end of a frame)
+static volatile uint16_t rowTicks = PANEL_DEFAULT_ROW_TICKS;
+//! Timer ticks per row that are currently used
+static uint16_t activeRowTicks = PANEL_DEFAULT_ROW_TICKS;
+//! Global brightness, 0 = off, 255 = LEDs lit for the whole row period
+static volatile uint8_t brightness = 255;
+//! Timer ticks a row stays lit if the brightness is dimmed (0 = not dimmed)
+static uint16_t onTicks = 0;
+
+//! Whether the refresh adapts to static and dark content
+static volatile bool autoMode = false;
+//! Set by everyone who writes to frameBuffer, cleared at the end of each frame
+volatile bool frameDirty = false;
+//! Number of frames without changes (saturates at PANEL_AUTO_STATIC_FRAMES)
+static uint8_t staticFrames = 0;
+//! Whether the current frame is scanned for lit planes
+static bool checkFrame = false;
+//! Planes with at least one lit pixel, collected during a check frame
+static uint8_t planesLit = 0;
+//! Planes that are shifted out, the others are left dark without any work
+static uint8_t planesShown = (1 << NUM_PLANES) - 1;
+//! Whether the refresh runs at PANEL_AUTO_IDLE_RATE because nothing changes
+static bool idle = false;
+
+//! Bit planes of the panel, bits 0-2 are RGB of the upper half, bits 3-5 RGB of the lower half
+volatile uint8_t frameBuffer[NUM_PLANES][NUM_DROWS][NUM_COLS];
+
+
+/*!
+ *  Timer ticks a row stays lit at the given brightness.
+ *
+ *  \return 0 if the row is not dimmed at all.
+ */
+static uint16_t panel_onTicks(uint16_t ticks, uint8_t value) {
+	if (value == 255) {
+		return 0;
+	}
+	const uint16_t on = ((uint32_t)ticks * value) >> 8;
+	return on ? on : 1;
+}
+
 //! \brief Enable compare match interrupts for Timer 1
 void panel_startTimer() {
     sbi(TIMSK1, OCIE1A);
+    if (brightness != 255) {
+        sbi(TIMSK1, OCIE1B);
+    }
 }
 
 //! \brief Disable compare match interrupts for Timer 1
 void panel_stopTimer() {
     cbi(TIMSK1, OCIE1A);
+    cbi(TIMSK1, OCIE1B);
 }
 
 //! \brief Initialization function of Timer 1
 void panel_initTimer() {
     // Configuration TCCR1B register
     sbi(TCCR1B, WGM12); // Clear on timer compare match
-    sbi(TCCR1B, CS12);  // Prescaler 256  1
-    cbi(TCCR1B, CS11);  // Prescaler 256  0
-    cbi(TCCR1B, CS10);  // Prescaler 256  0
+    cbi(TCCR1B, CS12);  // Prescaler 8  0
+    sbi(TCCR1B, CS11);  // Prescaler 8  1
+    cbi(TCCR1B, CS10);  // Prescaler 8  0
 
-    // Output Compare register 256*7 = 1792 tics => interrupt interval approx 0.0896 ms
-    OCR1A = 0x0007;
+    // Output Compare register 8*224 = 1792 tics => interrupt interval approx 0.0896 ms
+    // The fine prescaler gives OCR1B enough resolution for the brightness
+    OCR1A = PANEL_DEFAULT_ROW_TICKS - 1;
 }
 
-static uint8_t currentRow = 0;
-static uint8_t currentPlane = 0;
-uint8_t frameBuffer[NUM_PLANES][NUM_DROWS][NUM_COLS];
-
-
 //! \brief Initializes used ports of panel
 void panel_init(){
 	
@@ -49,7 +106,11 @@ void panel_init(){
 		DDRC |= (1 << PC0) | (1 << PC1) | (1 << PC6);               // CLK, LE, OE pins
 		DDRD |= (1 << PD0) | (1 << PD1) | (1 << PD2) | (1 << PD3) | (1 << PD4) | (1 << PD5);  // RGB data pins
 		
-		
+		// CLK and LE idle low (os_initInput may have enabled pull-ups), output off
+		PORTC &= ~((1 << PC0) | (1 << PC1));
+		PORTC |= (1 << PC6);
+		// These pins are no buttons any more, toggling CLK must not raise pin change interrupts
+		PCMSK2 &= ~((1 << PCINT16) | (1 << PCINT17) | (1 << PCINT22));
 		
 
 	
@@ -57,77 +118,258 @@ void panel_init(){
 //#error IMPLEMENT STH. HERE
 }
 
-void panel_latchEnable(){ 
-	
-	PORTC |= (1 << PC1); 
+/*!
+ *  \brief Number of frames the refresh ISR has completed so far
+ *
+ *  A frame consists of all rows of all planes (about 4.3 ms). The counter
+ *  counts frame periods at PANEL_DEFAULT_REFRESH_RATE, so animations keep
+ *  their speed when the refresh rate is changed. It wraps around, so only
+ *  differences of two values are meaningful.
+ */
+uint16_t panel_getFrameCount(void) {
+	uint16_t count;
+	uint8_t sreg = SREG;
+	cli();
+	count = frameCount;
+	SREG = sreg;
+	return count;
+}
+
+/*!
+ *  Sets the global brightness by shortening the time each row is lit. The
+ *  LEDs are switched off by the compare match B interrupt.
+ *
+ *  \param value 0 turns the panel off, 255 is full brightness.
+ */
+void panel_setBrightness(uint8_t value) {
+	ATOMIC {
+		brightness = value;
+		onTicks = panel_onTicks(activeRowTicks, value);
+		if (value == 255) {
+			cbi(TIMSK1, OCIE1B);
+		} else if (gbi(TIMSK1, OCIE1A)) {
+			TIFR1 = (1 << OCF1B);
+			sbi(TIMSK1, OCIE1B);
+		}
 	}
-	
-void panel_latchDisable(){ 
-	
-	PORTC &= ~(1 << PC1); 
+}
+
+//! \return The current global brightness
+uint8_t panel_getBrightness(void) {
+	return brightness;
+}
+
+/*!
+ *  Sets the number of full frames per second. The new rate is applied at the
+ *  end of the current frame. Lower rates take less CPU time but flicker more.
+ *
+ *  \param rate Frames per second, clamped to PANEL_MIN_REFRESH_RATE .. PANEL_MAX_REFRESH_RATE.
+ */
+void panel_setRefreshRate(uint16_t rate) {
+	if (rate < PANEL_MIN_REFRESH_RATE) {
+		rate = PANEL_MIN_REFRESH_RATE;
+	} else if (rate > PANEL_MAX_REFRESH_RATE) {
+		rate = PANEL_MAX_REFRESH_RATE;
 	}
-	
-void panel_outputEnable(){ 
-	PORTC &= ~(1 << PC6); 
+	const uint16_t ticks = PANEL_RATE_TO_ROW_TICKS(rate);
+	ATOMIC {
+		rowTicks = ticks;
 	}
-	
-void panel_outputDisable(){ 
-	PORTC |= (1 << PC6); 
- }
- 
-void panel_setAddress(uint8_t row){
-	
-	PORTA = (PORTA & 0xF0) | (row & 0x0F); 
 }
 
-void panel_setOutput(uint8_t data){
-	
-	PORTD = (0b00111111 & data); 
+//! \return The refresh rate set by panel_setRefreshRate in frames per second
+uint16_t panel_getRefreshRate(void) {
+	uint16_t ticks;
+	ATOMIC {
+		ticks = rowTicks;
+	}
+	return PANEL_RATE_TO_ROW_TICKS(ticks);
 }
 
-void panel_CLK(){
+/*!
+ *  Enables or disables the automatic mode. If the frame buffer has not been
+ *  written for PANEL_AUTO_STATIC_FRAMES frames, the refresh checks once which
+ *  planes contain lit pixels, skips the dark ones from then on and drops to
+ *  PANEL_AUTO_IDLE_RATE. The first write (see panel_markDirty) restores the
+ *  full refresh at the end of the frame.
+ *
+ *  \param enabled True to enable the automatic mode.
+ */
+void panel_setAutoMode(bool enabled) {
+	autoMode = enabled;
+	frameDirty = true;
+}
+
+/*!
+ *  Busy loop that runs for PANEL_LOAD_TICKS ticks of Timer 0.
+ *
+ *  \return Number of loop iterations, the less the more time the ISRs took.
+ */
+static uint32_t panel_countIdleLoops(void) {
+	uint32_t iterations = 0;
+	uint16_t ticks = 0;
+	uint8_t last = TCNT0;
+	while (ticks < PANEL_LOAD_TICKS) {
+		const uint8_t now = TCNT0;
+		ticks += (uint8_t)(now - last);
+		last = now;
+		iterations++;
+	}
+	return iterations;
+}
 
-	PORTC |= (1 << PC0); 
-	PORTC &= ~(1 << PC0); 
+/*!
+ *  Measures the share of CPU time taken by the refresh ISR. The same busy
+ *  loop runs for a fixed time once with and once without the refresh, the
+ *  scheduler is held off meanwhile. The panel stays dark for the second run
+ *  (about 50 ms).
+ *
+ *  \return CPU share of the panel refresh in percent.
+ */
+uint8_t panel_measureLoad(void) {
+	const bool running = gbi(TIMSK1, OCIE1A);
+	os_enterCriticalSection();
+	panel_startTimer();
+	const uint32_t refreshing = panel_countIdleLoops();
+	panel_stopTimer();
+	panel_outputDisable();
+	const uint32_t idle = panel_countIdleLoops();
+	if (running) {
+		panel_startTimer();
+	}
+	os_leaveCriticalSection();
+	if (!idle || refreshing >= idle) {
+		return 0;
+	}
+	return 100 - (uint8_t)(refreshing * 100 / idle);
 }
 
 
 
+//! Shifts out one column and clocks it into the panel (5 cycles)
+#define PANEL_SHIFT_COLUMN()      \
+	do {                          \
+		panel_setOutput(*data++); \
+		panel_CLK();              \
+	} while (0)
+
+//! Shifts out eight columns
+#define PANEL_SHIFT_8_COLUMNS() \
+	do {                        \
+		PANEL_SHIFT_COLUMN();   \
+		PANEL_SHIFT_COLUMN();   \
+		PANEL_SHIFT_COLUMN();   \
+		PANEL_SHIFT_COLUMN();   \
+		PANEL_SHIFT_COLUMN();   \
+		PANEL_SHIFT_COLUMN();   \
+		PANEL_SHIFT_COLUMN();   \
+		PANEL_SHIFT_COLUMN();   \
+	} while (0)
+
+/*!
+ *  Handles the end of a frame: applies a changed refresh rate and runs the
+ *  state machine of the automatic mode.
+ */
+static inline void panel_endOfFrame(void) {
+	if (!autoMode || frameDirty) {
+		frameDirty = false;
+		staticFrames = 0;
+		checkFrame = false;
+		idle = false;
+		planesShown = (1 << NUM_PLANES) - 1;
+	} else if (checkFrame) {
+		checkFrame = false;
+		idle = true;
+		planesShown = planesLit;
+	} else if (!idle && ++staticFrames == PANEL_AUTO_STATIC_FRAMES) {
+		checkFrame = true;
+		planesLit = 0;
+	}
 
-//! \brief ISR to refresh LED panel, trigger 1 compare match interrupts
+	uint16_t ticks = rowTicks;
+	if (idle && ticks < PANEL_RATE_TO_ROW_TICKS(PANEL_AUTO_IDLE_RATE)) {
+		ticks = PANEL_RATE_TO_ROW_TICKS(PANEL_AUTO_IDLE_RATE);
+	}
+	if (ticks != activeRowTicks) {
+		// TCNT1 is far below both values here, so the counter cannot miss the new top
+		activeRowTicks = ticks;
+		OCR1A = ticks - 1;
+		onTicks = panel_onTicks(ticks, brightness);
+	}
+}
+
+/*!
+ *  \brief ISR to refresh LED panel, trigger 1 compare match interrupts
+ *
+ *  The next row is shifted into the drivers while the previous one is still
+ *  lit, the LEDs are only switched off for changing the address and latching.
+ *  The column loop is unrolled and all helpers are inlined, so a column costs
+ *  ld + out + 2 * out (toggle via PINC) = 5 cycles and no call-clobbered
+ *  registers have to be saved. Together with the prologue the ISR takes about
+ *  220 of the 1792 cycles between two interrupts (the former version with a
+ *  loop calling panel_setOutput and panel_CLK needed about 1100).
+ *  Use panel_measureLoad to check the share on the target.
+ *
+ *  Rows of planes that are skipped by the automatic mode are not shifted out
+ *  at all and stay dark for their period, so the brightness does not change.
+ */
 ISR(TIMER1_COMPA_vect) {
-	
-	panel_outputDisable();
+	const uint8_t *data = scanRow;
+	const bool show = planesShown & currentPlaneBit;
 
-	
-	panel_setAddress(currentRow);
-	
+	if (show) {
+		PANEL_SHIFT_8_COLUMNS();
+		PANEL_SHIFT_8_COLUMNS();
+		PANEL_SHIFT_8_COLUMNS();
+		PANEL_SHIFT_8_COLUMNS();
+	} else {
+		data += NUM_COLS;
+	}
 
-	for (uint8_t col = 0; col < NUM_COLS; col++) {
-		
-		uint8_t data = frameBuffer[currentPlane][currentRow][col];
-		panel_setOutput(data);
-		panel_CLK(); 
+	panel_outputDisable();
+	if (show && brightness) {
+		panel_setAddress(currentRow);
+		panel_latchEnable();
+		panel_latchDisable();
+		panel_outputEnable();
+		if (onTicks) {
+			const uint16_t off = TCNT1 + onTicks;
+			// Never match together with OCR1A, that would switch off the next row
+			OCR1B = off < activeRowTicks - 1 ? off : 0xFFFF;
+			// A match of the old value during the shifting must not count
+			TIFR1 = (1 << OCF1B);
+		}
 	}
-	
-	
 
-	panel_latchEnable();
-	panel_latchDisable();
+	if (checkFrame) {
+		uint8_t lit = 0;
+		for (const uint8_t *col = data - NUM_COLS; col != data; col++) {
+			lit |= *col;
+		}
+		if (lit) {
+			planesLit |= currentPlaneBit;
+		}
+	}
 
-	
-	panel_outputEnable();
+	frameTicks += activeRowTicks;
+	if (frameTicks >= PANEL_FRAME_TICKS) {
+		frameTicks -= PANEL_FRAME_TICKS;
+		frameCount++;
+	}
 
-	
-	currentRow++;
-	if (currentRow >= NUM_DROWS) {
-		currentRow = 0;
-		currentPlane++;
-		if (currentPlane >= NUM_PLANES) {
-			currentPlane = 0;
+	currentRow = (currentRow + 1) & (NUM_DROWS - 1);
+	if (!currentRow) {
+		currentPlaneBit <<= 1;
+		if (currentPlaneBit == (1 << NUM_PLANES)) {
+			currentPlaneBit = 1;
+			data = (const uint8_t *)frameBuffer;
+			panel_endOfFrame();
 		}
 	}
-	
-	
-//#error IMPLEMENT STH. HERE
+	scanRow = data;
+}
+
+//! \brief Switches the LEDs off when a dimmed row has been lit long enough
+ISR(TIMER1_COMPB_vect) {
+	panel_outputDisable();
 }
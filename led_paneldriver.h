@@ -4,6 +4,8 @@
  */
 #ifndef _LED_PANELDRIVER_H
 #define _LED_PANELDRIVER_H
+#include "atmega644constants.h"
+
 #include <avr/io.h>
 #include <stdbool.h>
 
@@ -20,21 +22,104 @@ void panel_stopTimer(void);
 //! Initalizes interrupt timer
 void panel_initTimer(void);
 
+//! Number of completed panel frames
+uint16_t panel_getFrameCount(void);
+
+
+//! Sets the global brightness (0 = off, 255 = full)
+void panel_setBrightness(uint8_t value);
+
+//! Returns the global brightness
+uint8_t panel_getBrightness(void);
+
+//! Sets the refresh rate in frames per second
+void panel_setRefreshRate(uint16_t rate);
+
+//! Returns the refresh rate in frames per second
+uint16_t panel_getRefreshRate(void);
+
+//! Lets the refresh slow down and skip dark planes while the content does not change
+void panel_setAutoMode(bool enabled);
+
+//! Measures the CPU share of the refresh ISR in percent
+uint8_t panel_measureLoad(void);
+
+//! Timer 0 ticks (256 cycles each) of one run of panel_measureLoad, about 52 ms
+#define PANEL_LOAD_TICKS 4096
+
+
+// additional helper functions for LED matrix control, inlined into the refresh ISR
+static inline void panel_latchEnable(void) {
+    PORTC |= (1 << PC1);
+}
+
+static inline void panel_latchDisable(void) {
+    PORTC &= ~(1 << PC1);
+}
+
+static inline void panel_outputEnable(void) {
+    PORTC &= ~(1 << PC6);
+}
 
-// additional helper functions for LED matrix control
-void panel_latchEnable(void);
-void panel_latchDisable(void);
-void panel_outputEnable(void);
-void panel_outputDisable(void);
-void panel_setAddress(uint8_t row);
-void panel_setOutput(uint8_t data);
-void panel_CLK(void);
+static inline void panel_outputDisable(void) {
+    PORTC |= (1 << PC6);
+}
+
+static inline void panel_setAddress(uint8_t row) {
+    PORTA = (PORTA & 0xF0) | (row & 0x0F);
+}
+
+//! Frame buffer entries must not have bits outside PANEL_DATA_MASK set, they would end up on PD6/PD7
+static inline void panel_setOutput(uint8_t data) {
+    PORTD = data;
+}
+
+//! Clock pulse by toggling CLK twice through PINC (one cycle each)
+static inline void panel_CLK(void) {
+    PINC = (1 << PC0);
+    PINC = (1 << PC0);
+}
 
 
 #define NUM_PLANES 3
 #define NUM_DROWS 16
 #define NUM_COLS 32
 
+//! Timer 1 ticks (8 cycles each) per row at the default refresh rate
+#define PANEL_DEFAULT_ROW_TICKS 224
+
+//! Timer 1 ticks of one frame at the default refresh rate, the unit of panel_getFrameCount
+#define PANEL_FRAME_TICKS ((uint16_t)NUM_PLANES * NUM_DROWS * PANEL_DEFAULT_ROW_TICKS)
+
+//! Converts a refresh rate in frames per second into timer ticks per row and vice versa
+#define PANEL_RATE_TO_ROW_TICKS(rate) ((uint16_t)(F_CPU / 8 / ((uint32_t)NUM_PLANES * NUM_DROWS) / (rate)))
+
+//! Default refresh rate (about 232 frames per second)
+#define PANEL_DEFAULT_REFRESH_RATE PANEL_RATE_TO_ROW_TICKS(PANEL_DEFAULT_ROW_TICKS)
+
+//! Refresh rates accepted by panel_setRefreshRate (the ISR needs about 30 ticks per row)
+#define PANEL_MIN_REFRESH_RATE 30
+#define PANEL_MAX_REFRESH_RATE 500
+
+//! Frames without writes until the automatic mode treats the content as static
+#define PANEL_AUTO_STATIC_FRAMES 64
+
+//! Refresh rate of the automatic mode for static content
+#define PANEL_AUTO_IDLE_RATE 100
+
+//! Bits of a frame buffer entry that are wired to the panel (R1 G1 B1 R2 G2 B2)
+#define PANEL_DATA_MASK 0x3F
+
+//! The frame buffer that is shown by the refresh ISR
+extern volatile uint8_t frameBuffer[NUM_PLANES][NUM_DROWS][NUM_COLS];
+
+//! Set when frameBuffer has been written, see panel_markDirty
+extern volatile bool frameDirty;
+
+//! Tells the automatic mode of the refresh that the content has changed
+static inline void panel_markDirty(void) {
+    frameDirty = true;
+}
 
 
 
@@ -1,639 +0,0 @@
-/*! \file
- *  \brief CUSTOM CHAR PATTERNS
- *  \author Lehrstuhl Informatik 11 - RWTH Aachen
- */
-
-#include "led_patterns.h"
-
-#include <avr/pgmspace.h>
-#include <stdint.h>
-const uint64_t PROGMEM led_small_letters[] = {
-    LED_CUSTOM_CHAR_SMALL(
-        0b010,
-        0b101,
-        0b111,
-        0b101,
-        0b101
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b110,
-        0b101,
-        0b110,
-        0b101,
-        0b110
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b011,
-        0b100,
-        0b100,
-        0b100,
-        0b011
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b110,
-        0b101,
-        0b101,
-        0b101,
-        0b110
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b100,
-        0b111,
-        0b100,
-        0b111
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b100,
-        0b111,
-        0b100,
-        0b100
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b011,
-        0b100,
-        0b101,
-        0b101,
-        0b011
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b101,
-        0b101,
-        0b111,
-        0b101,
-        0b101
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b010,
-        0b010,
-        0b010,
-        0b111
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b001,
-        0b001,
-        0b001,
-        0b101,
-        0b111
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b101,
-        0b101,
-        0b110,
-        0b101,
-        0b101
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b100,
-        0b100,
-        0b100,
-        0b100,
-        0b111
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b101,
-        0b111,
-        0b101,
-        0b101,
-        0b101
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b110,
-        0b101,
-        0b101,
-        0b101,
-        0b101
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b101,
-        0b101,
-        0b101,
-        0b111
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b101,
-        0b111,
-        0b100,
-        0b100
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b101,
-        0b101,
-        0b111,
-        0b010
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b110,
-        0b101,
-        0b110,
-        0b101,
-        0b101
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b100,
-        0b111,
-        0b001,
-        0b111
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b010,
-        0b010,
-        0b010,
-        0b010
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b101,
-        0b101,
-        0b101,
-        0b101,
-        0b111
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b101,
-        0b101,
-        0b101,
-        0b101,
-        0b010
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b101,
-        0b101,
-        0b101,
-        0b111,
-        0b101
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b101,
-        0b101,
-        0b010,
-        0b101,
-        0b101
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b101,
-        0b101,
-        0b010,
-        0b010,
-        0b010
-    ),
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b001,
-        0b010,
-        0b100,
-        0b111
-    )};
-
-const uint64_t PROGMEM led_large_letters[] = {
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b11111,
-        0b10001,
-        0b10001
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11110,
-        0b10001,
-        0b10001,
-        0b11110,
-        0b10001,
-        0b10001,
-        0b11110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b10000,
-        0b10000,
-        0b10000,
-        0b10001,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11100,
-        0b10010,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10010,
-        0b11100
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11111,
-        0b10000,
-        0b10000,
-        0b11110,
-        0b10000,
-        0b10000,
-        0b11111
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11111,
-        0b10000,
-        0b10000,
-        0b11110,
-        0b10000,
-        0b10000,
-        0b10000
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b10000,
-        0b10111,
-        0b10001,
-        0b10001,
-        0b01111
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10001,
-        0b10001,
-        0b10001,
-        0b11111,
-        0b10001,
-        0b10001,
-        0b10001
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b00100,
-        0b00100,
-        0b00100,
-        0b00100,
-        0b00100,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b00111,
-        0b00010,
-        0b00010,
-        0b00010,
-        0b00010,
-        0b10010,
-        0b01100
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10001,
-        0b10010,
-        0b10100,
-        0b11000,
-        0b10100,
-        0b10010,
-        0b10001
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10000,
-        0b10000,
-        0b10000,
-        0b10000,
-        0b10000,
-        0b10000,
-        0b11111
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10001,
-        0b11011,
-        0b10101,
-        0b10101,
-        0b10001,
-        0b10001,
-        0b10001
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10001,
-        0b10001,
-        0b11001,
-        0b10101,
-        0b10011,
-        0b10001,
-        0b10001
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11110,
-        0b10001,
-        0b10001,
-        0b11110,
-        0b10000,
-        0b10000,
-        0b10000
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10101,
-        0b10010,
-        0b01101
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11110,
-        0b10001,
-        0b10001,
-        0b11110,
-        0b10100,
-        0b10010,
-        0b10001
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01111,
-        0b10000,
-        0b10000,
-        0b01110,
-        0b00001,
-        0b00001,
-        0b11110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11111,
-        0b00100,
-        0b00100,
-        0b00100,
-        0b00100,
-        0b00100,
-        0b00100
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b01010,
-        0b00100
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10101,
-        0b10101,
-        0b01010
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10001,
-        0b10001,
-        0b01010,
-        0b00100,
-        0b01010,
-        0b10001,
-        0b10001
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10001,
-        0b10001,
-        0b10001,
-        0b01010,
-        0b00100,
-        0b00100,
-        0b00100
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11111,
-        0b00001,
-        0b00010,
-        0b00100,
-        0b01000,
-        0b10000,
-        0b11111
-    ),
-
-};
-
-const uint64_t PROGMEM led_small_numbers[] = {
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b101,
-        0b101,
-        0b101,
-        0b111
-    ),
-
-    LED_CUSTOM_CHAR_SMALL(
-        0b001,
-        0b011,
-        0b101,
-        0b001,
-        0b001
-    ),
-
-    LED_CUSTOM_CHAR_SMALL(
-        0b110,
-        0b001,
-        0b010,
-        0b100,
-        0b111
-    ),
-
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b001,
-        0b111,
-        0b001,
-        0b111
-    ),
-
-    LED_CUSTOM_CHAR_SMALL(
-        0b101,
-        0b101,
-        0b111,
-        0b001,
-        0b001
-    ),
-
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b100,
-        0b111,
-        0b001,
-        0b111
-    ),
-
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b100,
-        0b111,
-        0b101,
-        0b111
-    ),
-
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b001,
-        0b001,
-        0b001,
-        0b001
-    ),
-
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b101,
-        0b111,
-        0b101,
-        0b111
-    ),
-
-    LED_CUSTOM_CHAR_SMALL(
-        0b111,
-        0b101,
-        0b111,
-        0b001,
-        0b111
-    ),
-};
-
-const uint64_t PROGMEM led_large_numbers[] = {
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b10001,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01100,
-        0b10100,
-        0b00100,
-        0b00100,
-        0b00100,
-        0b00100,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b00001,
-        0b00010,
-        0b00100,
-        0b01000,
-        0b11111
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b00001,
-        0b00110,
-        0b00001,
-        0b10001,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b10000,
-        0b10100,
-        0b10100,
-        0b11111,
-        0b00100,
-        0b00100,
-        0b00100
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11111,
-        0b10000,
-        0b11110,
-        0b00001,
-        0b00001,
-        0b10001,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b10000,
-        0b11110,
-        0b10001,
-        0b10001,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b11111,
-        0b10001,
-        0b00001,
-        0b00010,
-        0b00010,
-        0b00100,
-        0b00100
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b10001,
-        0b01110,
-        0b10001,
-        0b10001,
-        0b01110
-    ),
-
-    LED_CUSTOM_CHAR_LARGE(
-        0b01110,
-        0b10001,
-        0b10001,
-        0b01111,
-        0b00001,
-        0b10001,
-        0b01110
-    ),
-};
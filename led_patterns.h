@@ -108,11 +108,4 @@
     0b00011000                               \
 ))
 
-//! Patterns for the letters and numbers
-// we store these in arrays since that makes it easier to find
-// the corresponding pattern to an ascii char
-// (which is how these are used 99% of the time)
-const extern uint64_t PROGMEM led_small_letters[];
-const extern uint64_t PROGMEM led_large_letters[];
-const extern uint64_t PROGMEM led_small_numbers[];
-const extern uint64_t PROGMEM led_large_numbers[];
+// The patterns for letters and numbers are kept in the glyph atlas (see led_font.h)
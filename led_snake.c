@@ -8,27 +8,31 @@
 #include "led_snake.h"
 #include "led_draw.h"
 #include "led_paneldriver.h"
+#include "led_patterns.h"
 #include "lcd.h"
 
-#include <stdlib.h>
-#include <util/delay.h>
-#include <time.h>
+#include "snake_autopilot.h"
 
+#include "os_core.h"
+#include "os_kvstore.h"
+#include "os_memheap_drivers.h"
+#include "os_memory.h"
+#include "os_scheduler.h"
+#include "os_taskman.h"
+#include "util.h"
 
+#if SNAKE_HIGHSCORE_COUNT * 2 > OS_KV_VALUE_SIZE
+#error "The high score table does not fit into a value of the key/value store"
+#endif
 
 
 
-uint8_t maxScore = 0;
-uint8_t score = 0;
-uint8_t food_Position_X, food_Posision_Y;
-uint8_t isFoodEaten = 0;
 
-uint8_t headX;
-uint8_t headY;
-uint8_t snake_Direction;
-uint16_t lenght_Of_Snake;
+// Pixel-Schreibzugriffe des letzten Spielschritts (zum Nachmessen)
+uint16_t writes_Per_Tick = 0;
 
-RingBuffer snake_Body;
+// Beim Start gewählt, gilt auch für das zweite Spiel im geteilten Bildschirm
+static bool start_Autopilot = false;
 
 
 
@@ -38,21 +42,208 @@ void play_Snake(){
 	panel_initTimer();
 	panel_startTimer();
 	js_init();
-	initialize_State_Of_Game();
+
+	// Knopf beim Start gedrückt: der Computer spielt (Demo und Dauertest)
+	if (js_getButton()){
+		start_Autopilot = true;
+		os_waitForNoJoystickButtonInput();
+	}
+
+	// Joystick beim Start zur Seite gedrückt: zwei Spiele nebeneinander
+	Direction direction = js_getDirection();
+	if (direction == JS_LEFT || direction == JS_RIGHT){
+		draw_clearDisplay();
+		os_exec(play_Snake_Right_Half, DEFAULT_PRIORITY);
+		play_Snake_In(0, 0, NUM_COLS / 2, NUM_DROWS * 2);
+		return;
+	}
+	play_Snake_In(0, 0, NUM_COLS, NUM_DROWS * 2);
+}
+
+
+void play_Snake_Right_Half(){
+	play_Snake_In(NUM_COLS / 2, 0, NUM_COLS / 2, NUM_DROWS * 2);
+}
+
+
+void play_Snake_In(uint8_t x, uint8_t y, uint8_t columns, uint8_t rows){
+	// Zustand liegt auf dem Stack des Prozesses, der Ringpuffer im internen Heap
+	SnakeGame game;
+	if (!create_Game(&game, x, y, columns, rows)){
+		os_error("Snake: Heap voll");
+		return;
+	}
+	run_Game(&game);
+}
+
+
+bool create_Game(SnakeGame *game, uint8_t x, uint8_t y, uint8_t columns, uint8_t rows){
+	game->view = (SnakeViewport){x, y, columns, rows};
+	game->field = (SnakeField){columns, rows, SNAKE_DEFAULT_WALL_TOP};
+	uint16_t scores[SNAKE_HIGHSCORE_COUNT];
+	load_High_Scores(scores);
+	game->maxScore = scores[0];
+	game->requested = JS_NEUTRAL;
+	game->restarted = false;
+	game->panelUnlocks = draw_getUnlockCount();
+	js_openEvents(&game->input);
+	game->autopilot = start_Autopilot;
+	game->autopilotSteps = 0;
+	game->maxPlanTicks = 0;
+	game->statsStart = os_systemTime_precise();
+	game->ring = os_malloc(intHeap, snake_ringSize(&game->field));
+	return game->ring != 0;
+}
+
+
+void run_Game(SnakeGame *game){
+	initialize_State_Of_Game(game);
+
+	// Zeitpunkt des nächsten Spielschritts, unabhängig davon wie lange das Zeichnen dauert
+	Time next_Step = os_systemTime_precise();
 	while (1){
-		adjust_State_Of_Game(); // aktualisiere status des spiel je nach spiel umst�nde
-		if (js_getButton()){  // Pr�fe ob buttom gedr�kt ist
-			stop_Game();
+		// Eingabe zwischen den Schritten sammeln, damit kurze Bewegungen nicht verloren gehen
+		Direction direction = read_Joystick(game);
+		if (direction != JS_NEUTRAL){
+			game->requested = direction;
+		}
+
+		// Pausenmenü gibt es nur, wenn das Spiel das ganze Panel hat
+		if (game->view.columns == NUM_COLS && js_getButton()){  // Pr�fe ob buttom gedr�kt ist
+			stop_Game(game);
+			next_Step = os_systemTime_precise();
+		}
+
+		if (game->autopilot){
+			report_Autopilot(game);
+		}
+
+		redraw_If_Panel_Returned(game);
+
+		Time now = os_systemTime_precise();
+		uint8_t steps = 0;
+		while ((int32_t)(now - next_Step) >= 0 && steps < SNAKE_MAX_CATCH_UP_STEPS){
+			draw_takeWriteCount();
+			adjust_State_Of_Game(game); // aktualisiere status des spiel je nach spiel umst�nde
+			writes_Per_Tick = draw_takeWriteCount();
+			next_Step += step_Interval(game);
+			steps++;
+			if (game->restarted){
+				// Neues Spiel nach dem Game-Over-Bildschirm: Takt neu beginnen
+				game->restarted = false;
+				next_Step = os_systemTime_precise() + step_Interval(game);
+				break;
+			}
+		}
+		// Zu weit zurückgefallen (z.B. nach einer Pause): nicht weiter aufholen
+		if ((int32_t)(now - next_Step) >= 0){
+			next_Step = now + step_Interval(game);
+		}
+
+		// Rest der Zeit den anderen Prozessen überlassen
+		os_yield();
+	}
+}
+
+
+void report_Autopilot(SnakeGame *game){
+	Time now = os_systemTime_precise();
+	Time elapsed = now - game->statsStart;
+	// nur das linke Spiel schreibt auf das LCD
+	if (elapsed < SNAKE_AUTOPILOT_REPORT_MS || game->view.x != 0){
+		return;
+	}
+
+	// Schritte pro Sekunde mit einer Nachkommastelle, nicht während der Taskmanager das LCD benutzt
+	uint32_t rate = (uint32_t)game->autopilotSteps * 10000 / elapsed;
+	if (!os_taskManOpen()){
+		lcd_clear();
+		lcd_writeProgString(PSTR("AI steps/s "));
+		lcd_writeDec(rate / 10);
+		lcd_writeChar('.');
+		lcd_writeDec(rate % 10);
+		lcd_line2();
+		lcd_writeProgString(PSTR("plan max "));
+		uint32_t planUs = TIME_TICKS_TO_US(game->maxPlanTicks);
+		lcd_writeDec(planUs > UINT16_MAX ? UINT16_MAX : planUs);
+		lcd_writeProgString(PSTR("us"));
+	}
+
+	game->autopilotSteps = 0;
+	game->statsStart = now;
+}
+
+
+Direction read_Joystick(SnakeGame *game){
+	// Alle Richtungswechsel seit dem letzten Aufruf abholen, der letzte zählt.
+	// Jedes Spiel hat seinen eigenen Lesezeiger, im geteilten Bildschirm sehen beide alle Wechsel.
+	Direction direction = JS_NEUTRAL;
+	Direction event;
+	while (js_nextEvent(&game->input, &event)){
+		if (event != JS_NEUTRAL){
+			direction = event;
+		}
+	}
+	return direction;
+}
+
+
+void load_High_Scores(uint16_t scores[SNAKE_HIGHSCORE_COUNT]){
+	for (uint8_t i = 0; i < SNAKE_HIGHSCORE_COUNT; i++){
+		scores[i] = 0;
+	}
+	// fehlende Einträge (z.B. leeres EEPROM) bleiben 0
+	os_kvGet(OS_KV_KEY_SNAKE_HIGHSCORES, scores, SNAKE_HIGHSCORE_COUNT * sizeof(uint16_t));
+}
+
+
+uint8_t save_High_Score(uint16_t score){
+	uint16_t scores[SNAKE_HIGHSCORE_COUNT];
+	uint8_t rank = SNAKE_HIGHSCORE_COUNT;
+
+	if (score == 0){
+		return rank;
+	}
+
+	// beide Spielprozesse teilen sich die Tabelle
+	os_enterCriticalSection();
+	load_High_Scores(scores);
+	while (rank > 0 && scores[rank - 1] < score){
+		rank--;
+	}
+	if (rank < SNAKE_HIGHSCORE_COUNT){
+		for (uint8_t i = SNAKE_HIGHSCORE_COUNT - 1; i > rank; i--){
+			scores[i] = scores[i - 1];
 		}
-		_delay_ms(150);  // spielgeschwindigkeit steuern
+		scores[rank] = score;
+		// wird im Hintergrund geschrieben, das Game Over wartet nicht auf das EEPROM
+		os_kvSet(OS_KV_KEY_SNAKE_HIGHSCORES, scores, sizeof(scores));
+	}
+	os_leaveCriticalSection();
+	return rank;
+}
+
+
+Time step_Interval(const SnakeGame *game){
+	// alle SNAKE_SPEEDUP_SCORE Punkte wird das Spiel eine Stufe schneller
+	uint16_t level = game->state.score / SNAKE_SPEEDUP_SCORE;
+	if (level >= SNAKE_SPEED_LEVELS){
+		level = SNAKE_SPEED_LEVELS - 1;
 	}
+	return SNAKE_BASE_STEP_MS - level * SNAKE_SPEEDUP_MS;
 }
 
 
-void lose_Game(){
+void lose_Game(SnakeGame *game){
+	// Im geteilten Bildschirm nur die eigene Hälfte neu starten, der Computer spielt sofort weiter
+	if (game->view.columns < NUM_COLS || game->autopilot){
+		initialize_State_Of_Game(game);
+		return;
+	}
+
 	draw_clearDisplay();
 	
-	if (score >= maxScore){
+	if (game->state.score >= game->maxScore){
 		
 		draw_letter('G', 1, 2, COLOR_GREEN, false, false);
 		draw_letter('o', 5, 2, COLOR_GREEN, false, false);
@@ -70,7 +261,7 @@ void lose_Game(){
 		draw_letter('c', 13, 9, COLOR_GREEN, false, false);
 		draw_letter('r', 17, 9, COLOR_GREEN, false, false);
 		
-		draw_number(score, false, 22, 9, COLOR_BLUE, false, false);
+		draw_number(game->state.score, false, 22, 9, COLOR_BLUE, false, false);
 		
 		
 		draw_letter('h', 5, 15, COLOR_GREEN, false, false);
@@ -78,7 +269,7 @@ void lose_Game(){
 		draw_letter('c', 13, 15, COLOR_GREEN, false, false);
 		draw_letter('r', 17, 15, COLOR_GREEN, false, false);
 		
-		draw_number(maxScore, false, 22, 15, COLOR_BLUE, false, false);
+		draw_number(game->maxScore, false, 22, 15, COLOR_BLUE, false, false);
 		
 		
 		draw_letter('C', 1, 21, COLOR_WHITE, false, false);
@@ -115,7 +306,7 @@ void lose_Game(){
 		draw_letter('c', 13, 9, COLOR_GREEN, false, false);
 		draw_letter('r', 17, 9, COLOR_GREEN, false, false);
 		
-		draw_number(score, false, 22, 9, COLOR_BLUE, false, false);
+		draw_number(game->state.score, false, 22, 9, COLOR_BLUE, false, false);
 		
 		
 		draw_letter('h', 5, 15, COLOR_GREEN, false, false);
@@ -123,7 +314,7 @@ void lose_Game(){
 		draw_letter('c', 13, 15, COLOR_GREEN, false, false);
 		draw_letter('r', 17, 15, COLOR_GREEN, false, false);
 		
-		draw_number(maxScore, false, 22, 15, COLOR_BLUE, false, false);
+		draw_number(game->maxScore, false, 22, 15, COLOR_BLUE, false, false);
 		
 		
 		draw_letter('C', 1, 21, COLOR_WHITE, false, false);
@@ -146,23 +337,23 @@ void lose_Game(){
 	}
 	
 	while (!js_getButton()){
-		
+		os_yield();
 	}
 	
 	os_waitForNoJoystickButtonInput();
 
-	initialize_State_Of_Game();
+	initialize_State_Of_Game(game);
 }
 
 
 
 
-void stop_Game(){
+void stop_Game(SnakeGame *game){
 	os_waitForNoJoystickButtonInput();
 	draw_clearDisplay();
 	
 	
-	if (score >= maxScore){
+	if (game->state.score >= game->maxScore){
 		
 		draw_letter('P', 2, 1, COLOR_RED, false, true);
 		draw_letter('A', 8, 1, COLOR_RED, false, true);
@@ -176,7 +367,7 @@ void stop_Game(){
 		draw_letter('c', 13, 9, COLOR_GREEN, false, false);
 		draw_letter('r', 17, 9, COLOR_GREEN, false, false);
 		
-		draw_number(score, false, 22, 9, COLOR_BLUE, false, false);
+		draw_number(game->state.score, false, 22, 9, COLOR_BLUE, false, false);
 		
 		
 		draw_letter('h', 5, 15, COLOR_GREEN, false, false);
@@ -184,7 +375,7 @@ void stop_Game(){
 		draw_letter('c', 13, 15, COLOR_GREEN, false, false);
 		draw_letter('r', 17, 15, COLOR_GREEN, false, false);
 		
-		draw_number(maxScore, false, 22, 15, COLOR_BLUE, false, false);
+		draw_number(game->maxScore, false, 22, 15, COLOR_BLUE, false, false);
 		
 		
 		draw_letter('C', 1, 21, COLOR_WHITE, false, false);
@@ -218,7 +409,7 @@ void stop_Game(){
 		draw_letter('c', 13, 9, COLOR_YELLOW, false, false);
 		draw_letter('r', 17, 9, COLOR_YELLOW, false, false);
 		
-		draw_number(score, false, 22, 9, COLOR_BLUE, false, false);
+		draw_number(game->state.score, false, 22, 9, COLOR_BLUE, false, false);
 		
 		
 		draw_letter('h', 5, 15, COLOR_GREEN, false, false);
@@ -226,7 +417,7 @@ void stop_Game(){
 		draw_letter('c', 13, 15, COLOR_GREEN, false, false);
 		draw_letter('r', 17, 15, COLOR_GREEN, false, false);
 		
-		draw_number(maxScore, false, 22, 15, COLOR_BLUE, false, false);
+		draw_number(game->maxScore, false, 22, 15, COLOR_BLUE, false, false);
 		
 		
 		draw_letter('C', 1, 21, COLOR_WHITE, false, false);
@@ -253,465 +444,215 @@ void stop_Game(){
 			if (js_getDirection() == JS_NEUTRAL){
 				os_waitForNoJoystickButtonInput();
 				draw_clearDisplay();
-				redraw_Game_Field();
+				redraw_Game_Field(game);
 				break;
 			}
 			else{
 				
-				initialize_State_Of_Game();
+				initialize_State_Of_Game(game);
 				break;
 			}
 		}
+		os_yield();
 	}
 }
 
 
-void redraw_Game_Field(){
-	// Zeichne Spiel Feld
-	for (uint8_t i = 0; i < 32; i++){
-		draw_setPixel(i, FIELD_UP_ROW, COLOR_WHITE);
-	}
-	for (uint8_t i = 0; i < 32; i++){
-		draw_setPixel(i, FIELD_DOWN_ROW, COLOR_WHITE);
-	}
-	for (uint8_t i = 5; i < 32; i++){
-		draw_setPixel(FIELD_LEFT_COLUMN, i, COLOR_WHITE);
-	}
-	for (uint8_t i = 5; i < 32; i++){
-		draw_setPixel(FIELD_RIGHT_COLUMN, i, COLOR_WHITE);
-	}
-	
-	draw_letter('s', 2, 0, COLOR_WHITE, false, false);
-	
-	draw_number(score, true, 11, 0, COLOR_BLUE, false, false);
-	if (score > maxScore){
-		maxScore = score;
-	}
-	draw_letter('H', 16, 0, COLOR_WHITE, false, false);
-	draw_letter('S', 19, 0, COLOR_WHITE, false, false);
-	
-	draw_number(maxScore, true, 28, 0, COLOR_GREEN, false, false);
-	
-	
-	draw_setPixel(food_Position_X, food_Posision_Y, COLOR_YELLOW);
-	
-	
-	draw_setPixel(headX, headY, COLOR_RED);
-	
-	// Hilfskoordinaten
-	uint8_t x = headX;
-	uint8_t y = headY;
-	// Starte am letzten Ringbuffer-Index
-	uint16_t idx = snake_Body.head;
-
-	// Verfolge den Ringbuffer bis zum Schwanz
-	while (idx != snake_Body.tail) {
-		// Zwei Bit-Positionen zur�ckspringen
-		if (idx >= 2) {
-			idx = idx - 2;
-			} else {
-			idx = RINGBUFFER_SIZE - (2 - idx);
-		}
-
-		// Richtung aus dem Puffer lesen
-		uint8_t dir = load_Snake_Buffer_Bit_Pair(idx);
-
-		// Koordinaten anpassen
-		if (dir == RIGHT) {
-			x = x - 1;
-			} else if (dir == LEFT) {
-			x = x + 1;
-			} else if (dir == UP) {
-			y = y + 1;
-			} else if (dir == DOWN) {
-			y = y - 1;
-		}
-
-		// Segment zeichnen
-		draw_setPixel(x, y, COLOR_GREEN);
-	}
-}
-
-
-
-
-void setup_Snake(){
-	uint8_t head_Min_X   = FIELD_LEFT_COLUMN + 1;
-	uint8_t head_Max_X   = FIELD_RIGHT_COLUMN - 1;
-	uint8_t widthX = head_Max_X - head_Min_X + 1;
-	uint8_t head_Min_Y    = FIELD_UP_ROW + 1;
-	uint8_t head_Max_Y    = FIELD_DOWN_ROW - 1;
-	uint8_t heightY = head_Max_Y - head_Min_Y + 1;
-	headX = (rand() % widthX) + head_Min_X;
-	headY = (rand() % heightY) + head_Min_Y;
-	snake_Direction = rand() % 4;
-	lenght_Of_Snake = 1;
-	snake_Body.head = 0;
-	snake_Body.tail = 0;
+void draw_Cell(const SnakeGame *game, SnakeCell cell, Color color){
+	draw_setPixel(game->view.x + cell.x, game->view.y + cell.y, color);
 }
 
 
-void initialize_State_Of_Game(){
-	draw_clearDisplay();
+void redraw_Game_Field(SnakeGame *game){
+	draw_Game_Border(game);
+	draw_Game_Header(game);
 	
-	// Zeichne Spiel Feld
-	for (uint8_t i = 0; i < 32; i++){
-		draw_setPixel(i, FIELD_UP_ROW, COLOR_WHITE);
-	}
-	for (uint8_t i = 0; i < 32; i++){
-		draw_setPixel(i, FIELD_DOWN_ROW, COLOR_WHITE);
-	}
-	for (uint8_t i = 5; i < 32; i++){
-		draw_setPixel(FIELD_LEFT_COLUMN, i, COLOR_WHITE);
-	}
-	for (uint8_t i = 5; i < 32; i++){
-		draw_setPixel(FIELD_RIGHT_COLUMN, i, COLOR_WHITE);
-	}
 	
-	score = 0;
-	// zeichne score und high score
-	draw_letter('s', 2, 0, COLOR_WHITE, false, false);
-	draw_number(score, true, 11, 0, COLOR_BLUE, false, false);
-	if (score > maxScore){
-		maxScore = score;
-	}
-	draw_letter('H', 16, 0, COLOR_WHITE, false, false);
-	draw_letter('S', 19, 0, COLOR_WHITE, false, false);
-	draw_number(maxScore, true, 28, 0, COLOR_GREEN, false, false);
+	draw_Cell(game, game->state.food, COLOR_YELLOW);
 	
-	setup_Snake();
 	
-	draw_setPixel(headX, headY, COLOR_RED);
+	// Körper aus dem Belegungsgitter zeichnen
+	for (uint8_t y = game->field.wallTop + 1; y < game->field.rows - 1; y++){
+		for (uint8_t x = 1; x < game->field.columns - 1; x++){
+			if (snake_isOccupied(&game->state, x, y)){
+				draw_Cell(game, (SnakeCell){x, y}, COLOR_GREEN);
+			}
+		}
+	}
 	
-	produce_Food();
+	draw_Cell(game, game->state.head, COLOR_RED);
 }
 
 
-void adjust_State_Of_Game(){
-	Direction get_Snake_Direction = js_getDirection();
-	adjust_Snake_Direction(get_Snake_Direction);
-
-	adjust_Snake_Buffer();
-	
-	
-	walk_Snake();
-
-	
-	if (collision_Detection()){
-		
-		if (score > maxScore){
-			maxScore = score; 
-		}
-		lose_Game(); 
+// Eine Ansicht (z.B. die Heap-Karte des Taskmanagers) hatte das Panel: sie hat es
+// gelöscht und die inkrementellen Schritte wurden verworfen, also alles neu zeichnen
+void redraw_If_Panel_Returned(SnakeGame *game){
+	uint8_t unlocks = draw_getUnlockCount();
+	if (unlocks == game->panelUnlocks){
+		return;
 	}
+	game->panelUnlocks = unlocks;
+	draw_filledRectangle(game->view.x, game->view.y, game->view.x + game->view.columns - 1, game->view.y + game->view.rows - 1, COLOR_BLACK);
+	redraw_Game_Field(game);
+}
 
+
+void initialize_State_Of_Game(SnakeGame *game){
+	draw_filledRectangle(game->view.x, game->view.y, game->view.x + game->view.columns - 1, game->view.y + game->view.rows - 1, COLOR_BLACK);
 	
-	if (did_Snake_Eat(food_Position_X, food_Posision_Y)){
-		score++;
-		produce_Food(); 
-	}
-	
-	
-	draw_filledRectangle(0, 0, 31, 4, COLOR_YELLOW);
+	draw_Game_Border(game);
 	
-	// Zeichne Spiel Feld
-	for (uint8_t i = 0; i < 32; i++){
-		draw_setPixel(i, FIELD_UP_ROW, COLOR_WHITE);
-	}
-	for (uint8_t i = 0; i < 32; i++){
-		draw_setPixel(i, FIELD_DOWN_ROW, COLOR_WHITE);
-	}
-	for (uint8_t i = 5; i < 32; i++){
-		draw_setPixel(FIELD_LEFT_COLUMN, i, COLOR_WHITE);
-	}
-	for (uint8_t i = 5; i < 32; i++){
-		draw_setPixel(FIELD_RIGHT_COLUMN, i, COLOR_WHITE);
-	}
+	// Zufälliger Seed: die Zeit bis zum Spielstart hängt vom Spieler ab, die Position trennt gleichzeitig gestartete Spiele
+	uint32_t seed = os_systemTime_precise() ^ ((uint32_t)game->view.x << 24);
+	snake_init(&game->state, &game->field, (uint8_t *)game->ring, seed);
+#if SNAKE_REPLAY_BUFFER_SIZE > 0
+	snake_replayStart(&game->replay, game->replayBuffer, SNAKE_REPLAY_BUFFER_SIZE, &game->field, seed);
+#endif
 	
-	draw_letter('s', 2, 0, COLOR_WHITE, false, false);
+	// zeichne score und high score
+	draw_Game_Header(game);
 	
-	draw_number(score, true, 11, 0, COLOR_BLUE, false, false);
-	if (score > maxScore){
-		maxScore = score;
-	}
-	draw_letter('H', 16, 0, COLOR_WHITE, false, false);
-	draw_letter('S', 19, 0, COLOR_WHITE, false, false);
+	draw_Cell(game, game->state.head, COLOR_RED);
+	draw_Cell(game, game->state.food, COLOR_YELLOW);
 	
-	draw_number(maxScore, true, 28, 0, COLOR_GREEN, false, false);
-}
-
-
-void walk_Snake(){
-	  // l�sche alten kopf
-	  draw_setPixel(headX, headY, COLOR_BLACK);
-
-	  if (snake_Direction == RIGHT) {
-		  headX = headX + 1;
-		  } else if (snake_Direction == LEFT) {
-		  headX = headX - 1;
-		  } else if (snake_Direction == UP) {
-		  headY = headY - 1;
-		  } else if (snake_Direction == DOWN) {
-		  headY = headY + 1;
-	  }
-
-	  display_Snake();
-}
-
-
-void adjust_Snake_Direction(Direction newDirection){
-	// erhalte neu head direction von joystick
-	if (newDirection == JS_RIGHT) {
-		snake_Direction = RIGHT;
-		} else if (newDirection == JS_LEFT) {
-		snake_Direction = LEFT;
-		} else if (newDirection == JS_UP) {
-		snake_Direction = UP;
-		} else if (newDirection == JS_DOWN) {
-		snake_Direction = DOWN;
-	} 
+	game->requested = JS_NEUTRAL;
+	game->restarted = true;
 }
 
 
+void adjust_State_Of_Game(SnakeGame *game){
+	uint16_t oldScore = game->state.score;
+	uint16_t oldMaxScore = game->maxScore;
 
-void adjust_Snake_Buffer(){
-	// Nur wenn schlange l�nge gr�sser als 1 hat
-	if (lenght_Of_Snake > 1) {
-		// kopfzeiger um 2 bewegen
-		snake_Body.head += 2;
-		if (snake_Body.head >= RINGBUFFER_SIZE) {
-			snake_Body.head -= RINGBUFFER_SIZE;
-		}
-
-		// Byte-Index und Bit-Index berechnen
-		uint16_t byteIndex = snake_Body.head / 8;  
-		uint8_t  bitIndex  = snake_Body.head % 8;
-
-		// aktualisiere SnakeBodyBuffer
-		if (bitIndex == 0) {
-			
-			snake_Body.directions[byteIndex] &= 0xFC;        
-			snake_Body.directions[byteIndex] |= snake_Direction;
-		}
-		else if (bitIndex == 2) {
-			
-			snake_Body.directions[byteIndex] &= 0xF3;      
-			snake_Body.directions[byteIndex] |= (snake_Direction << 2);
-		}
-		else if (bitIndex == 4) {
-			
-			snake_Body.directions[byteIndex] &= 0xCF;        
-			snake_Body.directions[byteIndex] |= (snake_Direction << 4);
-		}
-		else if (bitIndex == 6) {
-			
-			snake_Body.directions[byteIndex] &= 0x3F;        
-			snake_Body.directions[byteIndex] |= (snake_Direction << 6);
-		}
-
-		// schwanz verschieben nur wenn kein essen gegessen wird
-		if (!isFoodEaten) {
-			snake_Body.tail += 2;
-			if (snake_Body.tail >= RINGBUFFER_SIZE) {
-				snake_Body.tail -= RINGBUFFER_SIZE;
-			}
+	SnakeDir input = adjust_Snake_Direction(game->requested);
+	if (game->autopilot){
+		// Planungszeit in Timer-0-Ticks messen, das Maximum ist entscheidend für den Takt
+		Time start = os_systemTime_ticks();
+		input = snake_autopilot(&game->state);
+		Time ticks = os_systemTime_ticks() - start;
+		if (ticks > game->maxPlanTicks){
+			game->maxPlanTicks = ticks;
 		}
-
-		// isFoodEaten zur�cksetzen
-		isFoodEaten = 0;
+		game->autopilotSteps++;
 	}
-}
+	SnakeStepResult result = snake_step(&game->state, input);
+	game->requested = JS_NEUTRAL;
+#if SNAKE_REPLAY_BUFFER_SIZE > 0
+	snake_replayRecord(&game->replay, game->state.direction);
+#endif
 
-
-uint8_t load_Snake_Buffer_Bit_Pair(uint16_t bitPairPosition){
-	// Bestimme in welchem Byte das Bit paar liegt
-	uint16_t byteIndex = bitPairPosition / 8;
-	// Bestimme an welcher Position im Byte das Bit-Paar beginnt (0, 2, 4 oder 6)
-	uint8_t bitIndex = bitPairPosition % 8;
-	// Lese das Byte aus dem Puffer
-	uint8_t byteValue = snake_Body.directions[byteIndex];
-	uint8_t pair = 0;
-
-	// Je nach Bit Position die passenden 2 Bits maskieren und nach rechts schieben
-	if (bitIndex == 0) {
-		
-		pair = byteValue & 0x03;        
-	}
-	else if (bitIndex == 2) {
-		
-		pair = (byteValue & 0x0C) >> 2; 
-	}
-	else if (bitIndex == 4) {
+	if (result.events & SNAKE_EVENT_DIED){
 		
-		pair = (byteValue & 0x30) >> 4;
-	}
-	else if (bitIndex == 6) {
-		
-		pair = (byteValue & 0xC0) >> 6; 
-	}
-
-	// Ergebnis zur�ckgeben
-	return pair;
-}
-
-
-void display_Snake(){
-	// Kopf zeichnen
-	draw_setPixel(headX, headY, COLOR_RED);
-
-	// wenn l�nge =1 dann fertig
-	if (lenght_Of_Snake == 1) {
+		// Punkte des Computerspielers kommen nicht in die Tabelle
+		if (!game->autopilot){
+			save_High_Score(game->state.score);
+		}
+		if (game->state.score > game->maxScore){
+			game->maxScore = game->state.score; 
+		}
+		lose_Game(game); 
 		return;
 	}
 
-	
-	uint8_t x = headX;
-	uint8_t y = headY;
-	uint16_t pos = snake_Body.head;
+	display_Snake(game, &result);
 
 	
-	// Erstes Segment direkt hinter dem Kopf zeichnen
-	// Richtung auslesen
-	uint8_t dir = load_Snake_Buffer_Bit_Pair(pos);
-	// Position anpassen
-	if (dir == RIGHT) {
-		x = x - 1;
-		} else if (dir == LEFT) {
-		x = x + 1;
-		} else if (dir == UP) {
-		y = y + 1;
-		} else if (dir == DOWN) {
-		y = y - 1;
-		}
-	// K�rpersegment zeichnen
-	draw_setPixel(x, y, COLOR_GREEN);
-	
-
-	// restlische segmente verfolgen
-	while (pos != snake_Body.tail) {
-		// Zum vorherigen Segment springen (2 Bit zur�ck)
-		if (pos >= 2) {
-			pos = pos - 2;
-			} else {
-			pos = RINGBUFFER_SIZE - (2 - pos);
+	if (result.events & SNAKE_EVENT_ATE){
+		if (game->state.score > game->maxScore){
+			game->maxScore = game->state.score;
 		}
-
-		// Richtung auslesen
-		uint8_t dir = load_Snake_Buffer_Bit_Pair(pos);
-		// Position anpassen
-		if (dir == RIGHT) {
-			x = x - 1;
-			} else if (dir == LEFT) {
-			x = x + 1;
-			} else if (dir == UP) {
-			y = y + 1;
-			} else if (dir == DOWN) {
-			y = y - 1;
+		// nur die geänderten Ziffern neu zeichnen
+		update_Score_Digits(game, oldScore, game->state.score, SCORE_X, COLOR_BLUE);
+		if (game->view.columns == NUM_COLS){
+			update_Score_Digits(game, oldMaxScore, game->maxScore, HIGHSCORE_X, COLOR_GREEN);
 		}
-	
+		draw_Cell(game, game->state.food, COLOR_YELLOW);
 	}
-
-	// alte Schwanz l�schen
-	draw_setPixel(x, y, COLOR_BLACK);
 }
 
 
-bool collision_Detection(){
-	// Pr�fe Kollision mit dem spielfeld
-	if (headX >= FIELD_RIGHT_COLUMN) {
-		return true;
+void draw_Game_Border(const SnakeGame *game){
+	uint8_t left = game->view.x;
+	uint8_t right = game->view.x + game->field.columns - 1;
+	uint8_t top = game->view.y + game->field.wallTop;
+	uint8_t bottom = game->view.y + game->field.rows - 1;
+	for (uint8_t i = left; i <= right; i++){
+		draw_setPixel(i, top, COLOR_WHITE);
+		draw_setPixel(i, bottom, COLOR_WHITE);
 	}
-	if (headX <= FIELD_LEFT_COLUMN) {
-		return true;
+	for (uint8_t i = top + 1; i < bottom; i++){
+		draw_setPixel(left, i, COLOR_WHITE);
+		draw_setPixel(right, i, COLOR_WHITE);
 	}
-	if (headY >= FIELD_DOWN_ROW) {
-		return true;
+}
+
+
+void draw_Game_Header(SnakeGame *game){
+	uint8_t x = game->view.x;
+	uint8_t y = game->view.y;
+	if (game->state.score > game->maxScore){
+		game->maxScore = game->state.score;
 	}
-	
-	if (headY <= FIELD_UP_ROW) {
-		return true;
+	draw_filledRectangle(x, y, x + game->view.columns - 1, y + game->field.wallTop - 1, COLOR_YELLOW);
+	draw_letter('s', x + 2, y, COLOR_WHITE, false, false);
+	draw_number(game->state.score, true, x + SCORE_X, y, COLOR_BLUE, false, false);
+	// Für den High Score ist nur auf dem ganzen Panel Platz
+	if (game->view.columns == NUM_COLS){
+		draw_letter('H', x + 16, y, COLOR_WHITE, false, false);
+		draw_letter('S', x + 19, y, COLOR_WHITE, false, false);
+		draw_number(game->maxScore, true, x + HIGHSCORE_X, y, COLOR_GREEN, false, false);
 	}
+}
 
-	// kollision mit sich selbst pr�fen
-	// Wir verfolgen die Schlange r�ckw�rts vom Kopf zum Schwanz
-	uint8_t x = headX;
-	uint8_t y = headY;
-	uint16_t position = snake_Body.head;
-
-	while (position != snake_Body.tail) {
-		// Zum vorherigen Bit-Paar springen (2 Bit zur�ck)
-		if (position >= 2) {
-			position = position - 2;
-			} else {
-			position = RINGBUFFER_SIZE - (2 - position);
-		}
-
-		// Richtung aus dem Puffer auslesen
-		uint8_t dir = load_Snake_Buffer_Bit_Pair(position);
-
-		// Koordinate entsprechend anpassen
-		if (dir == RIGHT) {
-			x = x - 1;
-			} else if (dir == LEFT) {
-			x = x + 1;
-			} else if (dir == UP) {
-			y = y + 1;
-			} else if (dir == DOWN) {
-			y = y - 1;
-		}
 
-		// Pr�fe ob kollision gibt
-		if (x == headX && y == headY) {
-			return true;
+void update_Score_Digits(const SnakeGame *game, uint16_t oldValue, uint16_t newValue, uint8_t x, Color color){
+	x += game->view.x;
+	// Ziffern von rechts nach links vergleichen, x ist die Spalte der Einerstelle
+	bool first = true;
+	while (first || oldValue || newValue){
+		uint8_t oldDigit = oldValue % 10;
+		uint8_t newDigit = newValue % 10;
+		// Stelle ohne Ziffer (führende Null) gilt als leer
+		bool oldShown = first || oldValue;
+		bool newShown = first || newValue;
+		if (oldShown != newShown || oldDigit != newDigit){
+			draw_filledRectangle(x, game->view.y, x + LED_CHAR_WIDTH_SMALL - 1, game->view.y + LED_CHAR_HEIGHT_SMALL - 1, COLOR_YELLOW);
+			if (newShown){
+				draw_decimal(newDigit, x, game->view.y, color, false, false);
+			}
 		}
+		oldValue /= 10;
+		newValue /= 10;
+		x -= LED_CHAR_WIDTH_SMALL + 1;
+		first = false;
 	}
-
-	// Keine Kollision gefunden
-	return false;
 }
 
 
-
-void produce_Food(){
-	// Spielfeld kordinate berechnen
-	uint8_t minX   = FIELD_LEFT_COLUMN + 1;
-	uint8_t maxX   = FIELD_RIGHT_COLUMN - 1;
-	uint8_t widthX = maxX - minX + 1;
-	uint8_t minY    = FIELD_UP_ROW + 1;
-	uint8_t maxY    = FIELD_DOWN_ROW - 1;
-	uint8_t heightY = maxY - minY + 1;
-
-	// food in random spot in fieled zeigen
-	food_Position_X = (rand() % widthX) + minX;
-	food_Posision_Y = (rand() % heightY) + minY;
-
-	// essen zeichnen
-	draw_setPixel(food_Position_X, food_Posision_Y, COLOR_YELLOW);
+SnakeDir adjust_Snake_Direction(Direction newDirection){
+	// erhalte neu head direction von joystick
+	if (newDirection == JS_RIGHT) {
+		return SNAKE_RIGHT;
+		} else if (newDirection == JS_LEFT) {
+		return SNAKE_LEFT;
+		} else if (newDirection == JS_UP) {
+		return SNAKE_UP;
+		} else if (newDirection == JS_DOWN) {
+		return SNAKE_DOWN;
+	} 
+	return SNAKE_KEEP;
 }
 
 
+void display_Snake(const SnakeGame *game, const SnakeStepResult *result){
+	// alter Kopf wird zum Körpersegment
+	draw_Cell(game, result->oldHead, COLOR_GREEN);
 
-bool did_Snake_Eat(uint8_t foodX, uint8_t foodY){
-	bool eaten = false;
-
-	// Kopf Position mit Essens Position vergleichen
-	if (headX == foodX && headY == foodY) {
-		// essen aus den display l�schen
-		draw_setPixel(foodX, foodY, COLOR_GREEN);
-
-		// Schlange um 1 verl�ngern
-		if (lenght_Of_Snake < MAXIMUM_LENGTH) {
-			lenght_Of_Snake = lenght_Of_Snake + 1;
-		}
-
-		// Flag setzen, damit der Ringbuffer wei�, dass wir gefressen haben
-		isFoodEaten = 1;
-
-		eaten = true;
+	// alte Schwanz löschen (vor dem Kopf, der Kopf kann gerade dort hinein laufen)
+	if (result->events & SNAKE_EVENT_TAIL_FREED) {
+		draw_Cell(game, result->freedTail, COLOR_BLACK);
 	}
 
-	// R�ckgabe, ob gegessen wurde
-	return eaten;
+	// Kopf zeichnen
+	draw_Cell(game, game->state.head, COLOR_RED);
 }
-
-
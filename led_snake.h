@@ -10,20 +10,16 @@
 #define LED_SNAKE_H_
 #include <stdint.h>
 #include <stdbool.h>
-
-//! Directions used by the snake game
-typedef enum {
-	SNAKE_UP = 0,
-	SNAKE_RIGHT = 1,
-	SNAKE_DOWN = 2,
-	SNAKE_LEFT = 3
-} SnakeDir;
+#include "snake_engine.h"
 
 //! Entry point of the snake application
 void snake_main(void);
 
 #include <stdbool.h>
 #include "joystick.h"
+#include "led_draw.h"
+#include "os_mem_drivers.h"
+#include "util.h"
 
 
 
@@ -31,75 +27,115 @@ void snake_main(void);
 
 
 
-void play_Snake(void);
+// Spielgeschwindigkeit: Dauer eines Schritts in ms, sinkt mit dem Score
+#define SNAKE_BASE_STEP_MS 150
+#define SNAKE_SPEEDUP_MS 10
+#define SNAKE_SPEEDUP_SCORE 5
+#define SNAKE_SPEED_LEVELS 10
 
+// Höchstens so viele verpasste Schritte werden nachgeholt
+#define SNAKE_MAX_CATCH_UP_STEPS 2
 
-void stop_Game(void);
+// Puffer für die Aufzeichnung des laufenden Spiels (4 Schritte pro Byte), 0 schaltet sie ab
+#define SNAKE_REPLAY_BUFFER_SIZE 0
 
-void lose_Game(void);
 
+// So oft schreibt der Computerspieler Schritte pro Sekunde und maximale Planungszeit auf das LCD
+#define SNAKE_AUTOPILOT_REPORT_MS 1000
 
-void initialize_State_Of_Game(void);
 
-void setup_Snake(void);
+// Anzahl der High Scores, die im EEPROM gespeichert werden (absteigend sortiert)
+#define SNAKE_HIGHSCORE_COUNT 5
 
-void walk_Snake(void);
 
+// Spalte der Einerstelle von Score und High Score (rechtsbündig, relativ zum Ausschnitt)
+#define SCORE_X 11
+#define HIGHSCORE_X 28
 
-void adjust_Snake_Direction(Direction newDirection);
 
-void adjust_Snake_Buffer(void);
+// Ausschnitt des Panels, in dem ein Spiel gezeichnet wird
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+	uint8_t columns;
+	uint8_t rows;
+} SnakeViewport;
 
 
-void adjust_State_Of_Game(void);
+// Alles, was zu einem laufenden Spiel gehört, damit mehrere Spiele gleichzeitig laufen können
+typedef struct {
+	SnakeState state;
+	SnakeField field;
+	SnakeViewport view;
+	// Ringpuffer der Richtungen im internen Heap (snake_ringSize Bytes)
+	MemAddr ring;
+	uint16_t maxScore;
+	// letzte Joystick-Eingabe seit dem vorherigen Schritt
+	Direction requested;
+	JsEventReader input;
+	bool restarted;
+	// draw_getUnlockCount beim letzten vollständigen Zeichnen
+	uint8_t panelUnlocks;
+	// Computerspieler und seine Statistik für das LCD
+	bool autopilot;
+	uint16_t autopilotSteps;
+	Time statsStart;
+	Time maxPlanTicks;
+#if SNAKE_REPLAY_BUFFER_SIZE > 0
+	SnakeReplay replay;
+	uint8_t replayBuffer[SNAKE_REPLAY_BUFFER_SIZE];
+#endif
+} SnakeGame;
 
 
+void play_Snake(void);
 
-uint8_t load_Snake_Buffer_Bit_Pair(uint16_t bitPairIndex);
+void play_Snake_Right_Half(void);
 
-bool collision_Detection(void);
+void play_Snake_In(uint8_t x, uint8_t y, uint8_t columns, uint8_t rows);
 
+bool create_Game(SnakeGame *game, uint8_t x, uint8_t y, uint8_t columns, uint8_t rows);
 
-bool did_Snake_Eat(uint8_t foodX, uint8_t foodY);
+void run_Game(SnakeGame *game);
 
-void display_Snake(void);
+Direction read_Joystick(SnakeGame *game);
 
-void produce_Food(void);
+void report_Autopilot(SnakeGame *game);
 
-void redraw_Game_Field(void);
+void load_High_Scores(uint16_t scores[SNAKE_HIGHSCORE_COUNT]);
 
+uint8_t save_High_Score(uint16_t score);
 
+Time step_Interval(const SnakeGame *game);
 
 
-#define MAXIMUM_LENGTH 1024
-#define RINGBUFFER_SIZE (2 * MAXIMUM_LENGTH)
+void stop_Game(SnakeGame *game);
 
+void lose_Game(SnakeGame *game);
 
-#define COLUMNS_NUMBER 32
-#define ROWS_NUMBER 32
 
-#define FIELD_UP_ROW 5
-#define FIELD_DOWN_ROW 31
-#define FIELD_LEFT_COLUMN 0
-#define FIELD_RIGHT_COLUMN 31
+void initialize_State_Of_Game(SnakeGame *game);
 
 
+SnakeDir adjust_Snake_Direction(Direction newDirection);
 
 
-#define RIGHT 0
-#define LEFT 1
-#define UP 2
-#define DOWN 3
+void adjust_State_Of_Game(SnakeGame *game);
 
-typedef struct {
-	uint16_t head;
-	uint16_t tail;
-	uint8_t directions[256];
-} RingBuffer;
 
+void display_Snake(const SnakeGame *game, const SnakeStepResult *result);
+
+void draw_Cell(const SnakeGame *game, SnakeCell cell, Color color);
+
+void redraw_Game_Field(SnakeGame *game);
+
+void redraw_If_Panel_Returned(SnakeGame *game);
 
+void draw_Game_Border(const SnakeGame *game);
 
+void draw_Game_Header(SnakeGame *game);
 
+void update_Score_Digits(const SnakeGame *game, uint16_t oldValue, uint16_t newValue, uint8_t x, Color color);
 
 
 
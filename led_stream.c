@@ -0,0 +1,238 @@
+/*! \file
+ *  \brief Streaming of panel content from a host over USART0
+ *
+ *  The RX interrupt only stores the received byte, all decoding is done by
+ *  stream_poll in process context.
+ */
+
+#include "led_stream.h"
+
+#include "atmega644constants.h"
+#include "led_paneldriver.h"
+#include "os_core.h"
+#include "os_memheap_drivers.h"
+#include "os_memory.h"
+#include "os_scheduler.h"
+#include "util.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+//! States of the packet decoder
+typedef enum {
+    STREAM_WAIT_SYNC,
+    STREAM_WAIT_CMD,
+    STREAM_FRAME_DATA,
+    STREAM_ROW_PLANE,
+    STREAM_ROW_ROW,
+    STREAM_ROW_COUNT,
+    STREAM_ROW_VALUE
+} StreamState;
+
+//! Everything that is only needed while the stream runs, it lives in the internal heap
+typedef struct {
+    //! RX ring buffer, filled by the ISR and drained by stream_poll
+    uint8_t rx[STREAM_RX_BUFFER_SIZE];
+    StreamStats stats;
+    StreamState state;
+    //! Byte index in a frame or column in a row of the current packet
+    uint16_t position;
+    uint8_t rowPlane;
+    uint8_t rowRow;
+    uint8_t runLength;
+} StreamContext;
+
+//! NULL while the stream is stopped
+static StreamContext *stream = NULL;
+static volatile uint8_t rxHead = 0;
+static volatile uint8_t rxTail = 0;
+
+//! Process that started the stream, INVALID_PROCESS while it is stopped
+static ProcessID streamProc = INVALID_PROCESS;
+
+//! Stores a received byte in the ring buffer or counts it as lost
+ISR(USART0_RX_vect) {
+    const uint8_t data = UDR0;
+    const uint8_t next = rxHead + 1;
+    if (next == rxTail) {
+        stream->stats.overflows++;
+        return;
+    }
+    stream->rx[rxHead] = data;
+    rxHead = next;
+}
+
+/*!
+ *  Takes the ring buffer and the decoder state from the internal heap,
+ *  initializes USART0 for 8N1 at STREAM_BAUD and enables the receiver and
+ *  its interrupt.
+ *
+ *  \return False if the stream is already running or the heap is full.
+ */
+bool stream_start(void) {
+    if (streamProc != INVALID_PROCESS) {
+        return false;
+    }
+    const MemAddr chunk = os_malloc(intHeap, sizeof(StreamContext));
+    if (!chunk) {
+        return false;
+    }
+    stream = (StreamContext *)chunk;
+    stream->stats = (StreamStats){0};
+    stream->state = STREAM_WAIT_SYNC;
+    rxHead = rxTail = 0;
+    streamProc = os_getCurrentProc();
+    UBRR0 = AVR_CLOCK_FREQUENCY / (8 * STREAM_BAUD) - 1;
+    UCSR0A = (1 << U2X0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+    UCSR0B = (1 << RXEN0) | (1 << RXCIE0);
+    return true;
+}
+
+/*!
+ *  Disables the receiver, so PD0 is driven by the panel again, and frees the
+ *  ring buffer and the decoder state. Called by os_kill for the process that
+ *  started the stream.
+ */
+void stream_stop(void) {
+    if (streamProc == INVALID_PROCESS) {
+        return;
+    }
+    UCSR0B = 0;
+    DDRD |= (1 << PD0);
+    streamProc = INVALID_PROCESS;
+    os_free(intHeap, (MemAddr)stream);
+    stream = NULL;
+}
+
+//! \return The process that started the stream, INVALID_PROCESS if it is stopped
+ProcessID stream_getProcess(void) {
+    return streamProc;
+}
+
+/*!
+ *  Feeds one byte into the packet decoder.
+ *
+ *  \param data The received byte.
+ *  \return True if the byte changed the frame buffer.
+ */
+static bool stream_decode(uint8_t data) {
+    switch (stream->state) {
+        case STREAM_WAIT_SYNC:
+            if (data == STREAM_SYNC) {
+                stream->state = STREAM_WAIT_CMD;
+            }
+            return false;
+
+        case STREAM_WAIT_CMD:
+            stream->position = 0;
+            if (data == STREAM_CMD_FRAME) {
+                stream->state = STREAM_FRAME_DATA;
+            } else if (data == STREAM_CMD_ROW) {
+                stream->state = STREAM_ROW_PLANE;
+            } else {
+                stream->stats.errors++;
+                stream->state = STREAM_WAIT_SYNC;
+            }
+            return false;
+
+        case STREAM_FRAME_DATA:
+            ((volatile uint8_t *)frameBuffer)[stream->position++] = data & PANEL_DATA_MASK;
+            if (stream->position == sizeof(frameBuffer)) {
+                panel_markDirty();
+                stream->stats.frames++;
+                stream->state = STREAM_WAIT_SYNC;
+            }
+            return true;
+
+        case STREAM_ROW_PLANE:
+            stream->rowPlane = data;
+            stream->state = STREAM_ROW_ROW;
+            return false;
+
+        case STREAM_ROW_ROW:
+            stream->rowRow = data;
+            if (stream->rowPlane >= NUM_PLANES || stream->rowRow >= NUM_DROWS) {
+                stream->stats.errors++;
+                stream->state = STREAM_WAIT_SYNC;
+            } else {
+                stream->state = STREAM_ROW_COUNT;
+            }
+            return false;
+
+        case STREAM_ROW_COUNT:
+            stream->runLength = data;
+            if (!stream->runLength || stream->position + stream->runLength > NUM_COLS) {
+                stream->stats.errors++;
+                stream->state = STREAM_WAIT_SYNC;
+            } else {
+                stream->state = STREAM_ROW_VALUE;
+            }
+            return false;
+
+        case STREAM_ROW_VALUE: {
+            volatile uint8_t *cell = &frameBuffer[stream->rowPlane][stream->rowRow][stream->position];
+            data &= PANEL_DATA_MASK;
+            stream->position += stream->runLength;
+            while (stream->runLength--) {
+                *cell++ = data;
+            }
+            panel_markDirty();
+            if (stream->position == NUM_COLS) {
+                stream->stats.rows++;
+                stream->state = STREAM_WAIT_SYNC;
+            } else {
+                stream->state = STREAM_ROW_COUNT;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ *  Decodes everything that is in the ring buffer. This has to be called often
+ *  enough for the buffer not to overflow (at STREAM_BAUD every 5 ms).
+ *
+ *  \return True if the frame buffer was changed.
+ */
+bool stream_poll(void) {
+    bool changed = false;
+    uint8_t tail = rxTail;
+    while (tail != rxHead) {
+        changed |= stream_decode(stream->rx[tail]);
+        rxTail = ++tail;
+    }
+    return changed;
+}
+
+/*!
+ *  \return A consistent copy of the link statistics, all zero while the
+ *          stream is stopped.
+ */
+StreamStats stream_getStats(void) {
+    StreamStats copy = {0};
+    ATOMIC {
+        if (stream) {
+            copy = stream->stats;
+        }
+    }
+    return copy;
+}
+
+/*!
+ *  Turns the panel into a display for the host: decodes packets as they come
+ *  in and hands the CPU to other processes when there is nothing to do.
+ */
+void stream_main(void) {
+    if (!stream_start()) {
+        os_error("Stream: Heap voll");
+        return;
+    }
+    while (1) {
+        if (!stream_poll()) {
+            os_yield();
+        }
+    }
+}
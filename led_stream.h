@@ -0,0 +1,70 @@
+/*! \file
+ *  \brief Streaming of panel content from a host over USART0
+ *
+ *  Received bytes are put into a ring buffer by the RX interrupt and decoded
+ *  by stream_poll, which writes straight into the planes of the frame buffer.
+ *
+ *  Protocol (all packets start with STREAM_SYNC):
+ *   - STREAM_SYNC 'F' <NUM_PLANES * NUM_DROWS * NUM_COLS bytes>
+ *     A full frame in the layout of frameBuffer ([plane][row][col]).
+ *   - STREAM_SYNC 'R' <plane> <row> (<count> <value>)...
+ *     One row of one plane, run-length encoded. The runs must add up to
+ *     exactly NUM_COLS columns.
+ *
+ *  At STREAM_BAUD = 500000 a full frame takes about 31 ms, run-length encoded
+ *  rows of typical content are a lot smaller.
+ *
+ *  Note that RXD0 is PD0, which is also the R1 data line of the panel. While
+ *  the receiver is enabled, the upper half shows no red channel.
+ */
+#ifndef _LED_STREAM_H
+#define _LED_STREAM_H
+#include "os_scheduler.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Baud rate of USART0 in streaming mode (exact at 20 MHz with double speed)
+#define STREAM_BAUD 500000ul
+
+//! First byte of every packet
+#define STREAM_SYNC 0xA5
+
+//! Packet types
+#define STREAM_CMD_FRAME 'F'
+#define STREAM_CMD_ROW 'R'
+
+//! Size of the RX ring buffer in the internal heap, must be 256 so the indices wrap by themselves
+#define STREAM_RX_BUFFER_SIZE 256
+
+//! Counters to check the link from the task manager or a debugger
+typedef struct {
+    //! Full frames received completely
+    uint16_t frames;
+    //! Rows received completely
+    uint16_t rows;
+    //! Bytes lost because the ring buffer was full
+    uint16_t overflows;
+    //! Packets that were dropped because of invalid content
+    uint16_t errors;
+} StreamStats;
+
+//! Allocates the ring buffer, initializes USART0 and enables the RX interrupt
+bool stream_start(void);
+
+//! Disables the receiver, gives PD0 back to the panel and frees the ring buffer
+void stream_stop(void);
+
+//! Returns the process that started the stream, INVALID_PROCESS if it is stopped
+ProcessID stream_getProcess(void);
+
+//! Decodes all bytes received so far, returns true if the frame buffer was changed
+bool stream_poll(void);
+
+//! Returns the link statistics
+StreamStats stream_getStats(void);
+
+//! Program that shows the host's content until it is killed (started by holding the joystick up at boot)
+void stream_main(void);
+
+#endif
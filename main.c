@@ -18,6 +18,7 @@ int main(void) {
 	os_init();
 	panel_init();
 	panel_initTimer();
+	panel_setAutoMode(true);
 	
     // os_init shows a boot message
     // Wait and clear the LCD
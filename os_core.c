@@ -3,6 +3,7 @@
 #include "defines.h"
 #include "lcd.h"
 #include "os_input.h"
+#include "os_kvstore.h"
 #include "util.h"
 
 #include "os_memheap_drivers.h"
@@ -123,6 +124,9 @@ void os_init(void) {
     // Init buttons
     os_initInput();
 
+    // Load the persistent values from the EEPROM
+    os_kvInit();
+
     // Init LCD display
     lcd_init();
     stdout = lcdout;
@@ -136,6 +140,10 @@ void os_init(void) {
 	if((uint16_t)&__heap_start >= HEAP_MAP_START){
 		os_error("ERROR ADJUST HEAPOFFSET");
 	}
+	// die globalen Variablen (frameBuffer, Puffer der Treiber) duerfen nicht in die Prozess-Stacks ragen
+	if((uint16_t)&__heap_start > TOP_OF_PROCS_STACKS){
+		os_error("ERROR GLOBALS IN STACKS");
+	}
 	
 	//os_initHeaps();
 	
@@ -1,7 +1,11 @@
 #include "os_input.h"
 
+#include "os_scheduler.h"
+
+#include <avr/interrupt.h>
 #include <avr/io.h>
 #include <stdint.h>
+#include <util/atomic.h>
 
 /*! \file
 
@@ -9,6 +13,30 @@ Everything that is necessary to get the input from the Buttons in a clean format
 
 */
 
+#if OS_INPUT_EVENT_QUEUE_SIZE & (OS_INPUT_EVENT_QUEUE_SIZE - 1)
+#error "OS_INPUT_EVENT_QUEUE_SIZE must be a power of two"
+#endif
+
+//! Button pins on port C
+#define OS_INPUT_PINS 0b11000011
+
+//! Debounced state and the number of debounce periods left (0 if no edge is pending)
+static volatile uint8_t inputState = 0;
+static uint8_t debouncePeriods = 0;
+//! Timer 0 ticks of the first edge of the pending debounce period
+static Time edgeTicks;
+
+//! Event ring buffer, written by the ISR
+static InputEvent events[OS_INPUT_EVENT_QUEUE_SIZE];
+static volatile uint8_t eventHead = 0;
+static volatile uint8_t eventTail = 0;
+static volatile uint8_t overflows = 0;
+
+static volatile bool chordPressed = false;
+//! The chord lacks buttons that are outputs now and the others are held since chordHeldSince
+static bool chordHeld = false;
+static Time chordHeldSince;
+
 /*!
  *  A simple "Getter"-Function for the Buttons on the evaluation board.\n
  *
@@ -27,26 +55,171 @@ uint8_t os_getInput(void) {
 }
 
 /*!
- *  Initializes DDR and PORT for input
+ *  Initializes DDR and PORT for input. The pin change interrupt is enabled
+ *  for all button pins, pins that are later used as outputs (e.g. by the
+ *  LED panel) have to be removed from PCMSK2 by their driver.
  */
 void os_initInput() {
 	DDRC &= 0b00111100;
 	PORTC |= 0b11000011;
+
+	inputState = os_getInput();
+	PCMSK2 = OS_INPUT_PINS;
+	PCIFR = (1 << PCIF2);
+	PCICR |= (1 << PCIE2);
 //#error IMPLEMENT STH. HERE
 }
 
+//! Buttons whose pins still are inputs with an enabled pin change interrupt
+static uint8_t os_availableInputs(void) {
+	return ((PCMSK2 & 0b11000000) >> 4) | (PCMSK2 & 0b00000011);
+}
+
+/*!
+ *  First edge on a button: the pin change interrupt stays off for the
+ *  debounce period, so bouncing contacts cost no further interrupts.
+ */
+ISR(PCINT2_vect) {
+	edgeTicks = os_systemTime_ticks();
+	debouncePeriods = OS_INPUT_DEBOUNCE_PERIODS;
+	PCICR &= ~(1 << PCIE2);
+	// One full timer period until the first match
+	OCR2B = TCNT2;
+	TIFR2 = (1 << OCF2B);
+	TIMSK2 |= (1 << OCIE2B);
+}
+
+//! End of a debounce period, turns the changes into events
+ISR(TIMER2_COMPB_vect) {
+	if (--debouncePeriods) {
+		return;
+	}
+	TIMSK2 &= ~(1 << OCIE2B);
+
+	const uint8_t state = os_getInput() & os_availableInputs();
+	const uint8_t changed = state ^ inputState;
+	for (uint8_t button = 0; button < 4; button++) {
+		if (!(changed & (1 << button))) {
+			continue;
+		}
+		const uint8_t next = (eventHead + 1) % OS_INPUT_EVENT_QUEUE_SIZE;
+		if (next == eventTail) {
+			overflows++;
+			continue;
+		}
+		events[eventHead] = (InputEvent){edgeTicks, button, state & (1 << button)};
+		eventHead = next;
+	}
+	// Buttons of the chord that are outputs now (e.g. Enter as CLK of the panel) are left out
+	const uint8_t chord = OS_INPUT_CHORD_TASKMAN & os_availableInputs();
+	const bool complete = chord && (state & chord) == chord;
+	if (complete && !(chord && (inputState & chord) == chord)) {
+		if (chord == OS_INPUT_CHORD_TASKMAN) {
+			chordPressed = true;
+		} else {
+			chordHeld = true;
+			chordHeldSince = edgeTicks;
+		}
+	}
+	if (!complete) {
+		chordHeld = false;
+	}
+	inputState = state;
+
+	// Edges during the period are covered by the read above
+	PCIFR = (1 << PCIF2);
+	PCICR |= (1 << PCIE2);
+}
+
+/*!
+ *  \return The debounced state of the buttons, bit n is button n.
+ */
+uint8_t os_getInputState(void) {
+	return inputState;
+}
+
+/*!
+ *  \param event Receives the event, its time is converted to ms.
+ *  \return False if there is no event.
+ */
+bool os_getInputEvent(InputEvent *event) {
+	bool available = false;
+	ATOMIC {
+		if (eventTail != eventHead) {
+			*event = events[eventTail];
+			eventTail = (eventTail + 1) % OS_INPUT_EVENT_QUEUE_SIZE;
+			available = true;
+		}
+	}
+	if (available) {
+		event->time = TIME_TICKS_TO_MS(event->time);
+	}
+	return available;
+}
+
+/*!
+ *  Hands the CPU to other processes until an event arrives.
+ */
+InputEvent os_waitForInputEvent(void) {
+	InputEvent event;
+	while (!os_getInputEvent(&event)) {
+		os_yield();
+	}
+	return event;
+}
+
+/*!
+ *  If buttons of the chord are not available, the remaining ones have to
+ *  be held for OS_INPUT_CHORD_HOLD_MS instead. Called by the scheduler in
+ *  every time slice, which also checks the hold time.
+ *
+ *  \return True once for every time the chord was completed.
+ */
+bool os_takeInputChord(void) {
+	bool pressed;
+	ATOMIC {
+		if (chordHeld && TIME_TICKS_TO_MS(os_systemTime_ticks() - chordHeldSince) >= OS_INPUT_CHORD_HOLD_MS) {
+			chordHeld = false;
+			chordPressed = true;
+		}
+		pressed = chordPressed;
+		chordPressed = false;
+	}
+	return pressed;
+}
+
+//! \return Events lost since the start
+uint8_t os_getInputOverflows(void) {
+	return overflows;
+}
+
 /*!
- *  Endless loop as long as at least one button is pressed.
+ *  Waits as long as at least one button is pressed. With interrupts enabled
+ *  the debounced state is used and the CPU is handed to other processes,
+ *  otherwise (in an ISR, before the scheduler runs or on an error screen)
+ *  the pins are polled.
  */
 void os_waitForNoInput() {
-	while (os_getInput() != 0);
+	if (!(SREG & (1 << 7))) {
+		while (os_getInput() != 0);
+		return;
+	}
+	while (os_getInputState() != 0) {
+		os_yield();
+	}
 //#error IMPLEMENT STH. HERE
 }
 
 /*!
- *  Endless loop until at least one button is pressed.
+ *  Waits until at least one button is pressed, like os_waitForNoInput.
  */
 void os_waitForInput() {
-	while (os_getInput() == 0);
+	if (!(SREG & (1 << 7))) {
+		while (os_getInput() == 0);
+		return;
+	}
+	while (os_getInputState() == 0) {
+		os_yield();
+	}
 //#error IMPLEMENT STH. HERE
 }
@@ -3,14 +3,44 @@
  *
  *  Contains functionalities to read user input.
  *
+ *  The buttons are watched by the pin change interrupt. An edge starts a
+ *  debounce period on compare unit B of the scheduler timer; when it ends,
+ *  the pins are read again and every button that changed its state yields
+ *  a press or release event with the time of the first edge. Edges that
+ *  are undone within the period are ignored.
+ *
  *  \author Lehrstuhl Informatik 11 - RWTH Aachen
  */
 
 #ifndef _OS_INPUT_H
 #define _OS_INPUT_H
 
+#include "util.h"
+
+#include <stdbool.h>
 #include <stdint.h>
 
+//! Number of scheduler timer periods (3.1 ms each) the buttons have to be stable
+#define OS_INPUT_DEBOUNCE_PERIODS 2
+
+//! Size of the event ring buffer (6 bytes per event), must be a power of two
+#define OS_INPUT_EVENT_QUEUE_SIZE 4
+
+//! Enter + ESC, opens the task manager
+#define OS_INPUT_CHORD_TASKMAN ((1 << 0) | (1 << 3))
+
+//! While the LED panel uses Enter, ESC alone has to be held this long (ms) instead
+#define OS_INPUT_CHORD_HOLD_MS 1000
+
+//! A button was pressed or released
+typedef struct {
+    //! System time of the first edge in ms
+    Time time;
+    //! Number of the button (bit in the value of os_getInput)
+    uint8_t button;
+    bool pressed;
+} InputEvent;
+
 //----------------------------------------------------------------------------
 // Function headers
 //----------------------------------------------------------------------------
@@ -27,4 +57,19 @@ void os_waitForNoInput(void);
 //! Waits for at least one button to be pressed
 void os_waitForInput(void);
 
+//! Debounced button states in the format of os_getInput
+uint8_t os_getInputState(void);
+
+//! Takes the oldest event from the ring buffer
+bool os_getInputEvent(InputEvent *event);
+
+//! Waits for the next event without using CPU time
+InputEvent os_waitForInputEvent(void);
+
+//! Whether the task manager chord was pressed since the last call
+bool os_takeInputChord(void);
+
+//! Number of events lost because the ring buffer was full
+uint8_t os_getInputOverflows(void);
+
 #endif
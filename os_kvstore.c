@@ -0,0 +1,310 @@
+/*! \file
+ *  \brief Persistent key/value store in the internal EEPROM
+ *
+ *  All bookkeeping (current values, dirty flags, slot of the current record
+ *  of each key and the head of the log) is in RAM and rebuilt by os_kvInit.
+ *  The record being written is not buffered, its bytes are built on the fly.
+ *  The writer state is shared with the EEPROM ready ISR, so it is only
+ *  changed with interrupts disabled.
+ */
+
+#include "os_kvstore.h"
+
+#include "os_scheduler.h"
+#include "util.h"
+
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+//! Marks a key without a record in the log
+#define OS_KV_NO_SLOT 0xFF
+
+//! Offsets in a record
+#define OS_KV_OFFSET_KEY 2
+#define OS_KV_OFFSET_LENGTH 3
+#define OS_KV_OFFSET_VALUE 4
+#define OS_KV_OFFSET_CHECKSUM (OS_KV_RECORD_SIZE - 1)
+
+//! Current values
+static uint8_t values[OS_KV_MAX_KEYS][OS_KV_VALUE_SIZE];
+static uint8_t lengths[OS_KV_MAX_KEYS];
+//! Keys whose value differs from their record
+static volatile uint8_t dirty = 0;
+//! Slot of the current record of each key
+static uint8_t slots[OS_KV_MAX_KEYS];
+
+//! Next slot to be written and the sequence number it gets
+static uint8_t head = 0;
+static uint16_t sequence = 0;
+
+//! Key whose record the ISR is writing, OS_KV_MAX_KEYS if it is idle
+static uint8_t recordKey = OS_KV_MAX_KEYS;
+static uint8_t recordSlot;
+static uint8_t recordByte;
+
+static uint16_t os_kvSlotAddress(uint8_t slot) {
+    return OS_KV_LOG_START + (uint16_t)slot * OS_KV_RECORD_SIZE;
+}
+
+//! Adds a byte to the checksum of a record
+static uint8_t os_kvChecksumStep(uint8_t sum, uint8_t data) {
+    return (sum << 1 | sum >> 7) ^ data;
+}
+
+//! Checksum of a record, a blank slot (all 0xFF) never matches
+static uint8_t os_kvChecksum(const uint8_t *data) {
+    uint8_t sum = 0x5A;
+    for (uint8_t i = 0; i < OS_KV_OFFSET_CHECKSUM; i++) {
+        sum = os_kvChecksumStep(sum, data[i]);
+    }
+    return sum;
+}
+
+/*!
+ *  Byte of the record that is being written, built from the current value of
+ *  its key (os_kvSet restarts the record when the value changes meanwhile).
+ *  The sequence number of the record is sequence - 1.
+ */
+static uint8_t os_kvRecordByte(uint8_t index) {
+    const uint16_t number = sequence - 1;
+    switch (index) {
+        case 0:
+            return number;
+        case 1:
+            return number >> 8;
+        case OS_KV_OFFSET_KEY:
+            return recordKey;
+        case OS_KV_OFFSET_LENGTH:
+            return lengths[recordKey];
+        case OS_KV_OFFSET_CHECKSUM: {
+            uint8_t sum = 0x5A;
+            for (uint8_t i = 0; i < OS_KV_OFFSET_CHECKSUM; i++) {
+                sum = os_kvChecksumStep(sum, os_kvRecordByte(i));
+            }
+            return sum;
+        }
+        default:
+            return values[recordKey][index - OS_KV_OFFSET_VALUE];
+    }
+}
+
+static bool os_kvSlotInUse(uint8_t slot) {
+    for (uint8_t key = 0; key < OS_KV_MAX_KEYS; key++) {
+        if (slots[key] == slot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ *  Prepares the record of the next dirty key. Must be called with interrupts
+ *  disabled and no record in progress.
+ *
+ *  \return False if nothing is dirty.
+ */
+static bool os_kvNextRecord(void) {
+    uint8_t key = 0;
+    while (key < OS_KV_MAX_KEYS && !(dirty & (1 << key))) {
+        key++;
+    }
+    if (key == OS_KV_MAX_KEYS) {
+        return false;
+    }
+    dirty &= ~(1 << key);
+
+    // Slots with the current record of a key are not overwritten, there is always a free one
+    while (os_kvSlotInUse(head)) {
+        head = (head + 1) % OS_KV_LOG_SLOTS;
+    }
+
+    recordKey = key;
+    recordSlot = head;
+    recordByte = 0;
+    head = (head + 1) % OS_KV_LOG_SLOTS;
+    sequence++;
+    return true;
+}
+
+/*!
+ *  Writes the next byte of the current record that differs from the EEPROM
+ *  content. Unchanged bytes are skipped, which saves a write cycle each.
+ *  When a record is complete, it becomes the current one of its key and the
+ *  next dirty key is started. The interrupt is disabled when all is written.
+ */
+ISR(EE_READY_vect) {
+    while (recordKey < OS_KV_MAX_KEYS) {
+        const uint16_t address = os_kvSlotAddress(recordSlot) + recordByte;
+        if (recordByte == OS_KV_RECORD_SIZE) {
+            slots[recordKey] = recordSlot;
+            recordKey = OS_KV_MAX_KEYS;
+            os_kvNextRecord();
+            continue;
+        }
+        const uint8_t data = os_kvRecordByte(recordByte++);
+        EEAR = address;
+        EECR |= (1 << EERE);
+        if (EEDR != data) {
+            EEDR = data;
+            EECR |= (1 << EEMPE);
+            EECR |= (1 << EEPE);
+            return;
+        }
+    }
+    EECR &= ~(1 << EERIE);
+}
+
+/*!
+ *  Scans the whole log for the newest valid record of every key. Sequence
+ *  numbers are compared with wrap around, there are never more than
+ *  OS_KV_LOG_SLOTS numbers in use at the same time.
+ */
+void os_kvInit(void) {
+    uint16_t newest[OS_KV_MAX_KEYS] = {0};
+    bool any = false;
+    uint8_t data[OS_KV_RECORD_SIZE];
+
+    ATOMIC {
+        for (uint8_t key = 0; key < OS_KV_MAX_KEYS; key++) {
+            slots[key] = OS_KV_NO_SLOT;
+            lengths[key] = 0;
+        }
+        dirty = 0;
+        head = 0;
+        sequence = 0;
+    }
+
+    for (uint8_t slot = 0; slot < OS_KV_LOG_SLOTS; slot++) {
+        eeprom_read_block(data, (const void *)os_kvSlotAddress(slot), OS_KV_RECORD_SIZE);
+        const uint8_t key = data[OS_KV_OFFSET_KEY];
+        if (key >= OS_KV_MAX_KEYS || data[OS_KV_OFFSET_LENGTH] > OS_KV_VALUE_SIZE || data[OS_KV_OFFSET_CHECKSUM] != os_kvChecksum(data)) {
+            continue;
+        }
+        const uint16_t number = data[0] | (uint16_t)data[1] << 8;
+        if (slots[key] == OS_KV_NO_SLOT || (int16_t)(number - newest[key]) > 0) {
+            slots[key] = slot;
+            newest[key] = number;
+            lengths[key] = data[OS_KV_OFFSET_LENGTH];
+            for (uint8_t i = 0; i < OS_KV_VALUE_SIZE; i++) {
+                values[key][i] = data[OS_KV_OFFSET_VALUE + i];
+            }
+        }
+        // The log continues after the newest record of all keys
+        if (!any || (int16_t)(number - sequence) >= 0) {
+            sequence = number + 1;
+            head = (slot + 1) % OS_KV_LOG_SLOTS;
+            any = true;
+        }
+    }
+}
+
+/*!
+ *  \param key    The key to read.
+ *  \param buffer Receives the value.
+ *  \param size   Size of buffer, longer values are truncated.
+ *  \return Length of the value, 0 if the key was never set.
+ */
+uint8_t os_kvGet(uint8_t key, void *buffer, uint8_t size) {
+    uint8_t length = 0;
+    if (key >= OS_KV_MAX_KEYS) {
+        return 0;
+    }
+    ATOMIC {
+        length = lengths[key];
+        for (uint8_t i = 0; i < length && i < size; i++) {
+            ((uint8_t *)buffer)[i] = values[key][i];
+        }
+    }
+    return length;
+}
+
+/*!
+ *  Returns right away, the record is written by the EEPROM ready ISR
+ *  (about 3.4 ms per changed byte).
+ *
+ *  \param key    The key to change.
+ *  \param value  The new value.
+ *  \param length Length of the value (at most OS_KV_VALUE_SIZE).
+ *  \return False if the key or the length is invalid.
+ */
+bool os_kvSet(uint8_t key, const void *value, uint8_t length) {
+    if (key >= OS_KV_MAX_KEYS || length > OS_KV_VALUE_SIZE) {
+        return false;
+    }
+    ATOMIC {
+        for (uint8_t i = 0; i < OS_KV_VALUE_SIZE; i++) {
+            values[key][i] = i < length ? ((const uint8_t *)value)[i] : 0xFF;
+        }
+        lengths[key] = length;
+        if (key == recordKey) {
+            // The bytes written so far are compared again, only changed ones cost a write
+            recordByte = 0;
+        } else {
+            dirty |= (1 << key);
+            if (recordKey == OS_KV_MAX_KEYS && os_kvNextRecord()) {
+                EECR |= (1 << EERIE);
+            }
+        }
+    }
+    return true;
+}
+
+//! \return True while a value is dirty or a record is being written
+bool os_kvPending(void) {
+    bool pending;
+    ATOMIC {
+        pending = dirty || recordKey < OS_KV_MAX_KEYS;
+    }
+    return pending;
+}
+
+/*!
+ *  Waits until everything is in the EEPROM, e.g. before the power is cut.
+ *  Must not be called from the idle process (use os_kvPending there).
+ */
+void os_kvFlush(void) {
+    while (os_kvPending()) {
+        os_yield();
+    }
+}
+
+
+static void intEEPROM_init(void) {
+}
+
+/*!
+ *  The EEPROM can not be accessed while a byte is written. Waiting for that
+ *  is done with interrupts enabled, so the panel keeps refreshing; once it is
+ *  ready with interrupts disabled, the ISR can not start the next byte.
+ */
+static MemValue intEEPROM_read(MemAddr addr) {
+    while (1) {
+        ATOMIC {
+            if (!(EECR & (1 << EEPE))) {
+                return eeprom_read_byte((const uint8_t *)addr);
+            }
+        }
+    }
+}
+
+//! Starts the write and returns, the next access waits for its end
+static void intEEPROM_write(MemAddr addr, MemValue value) {
+    while (1) {
+        ATOMIC {
+            if (!(EECR & (1 << EEPE))) {
+                eeprom_update_byte((uint8_t *)addr, value);
+                return;
+            }
+        }
+    }
+}
+
+MemDriver intEEPROM__ = {
+    .init = intEEPROM_init,
+    .read = intEEPROM_read,
+    .write = intEEPROM_write,
+    .start = 0,
+    .size = AVR_MEMORY_EEPROM
+};
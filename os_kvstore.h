@@ -0,0 +1,70 @@
+/*! \file
+ *  \brief Persistent key/value store in the internal EEPROM
+ *
+ *  The EEPROM is used as a log of fixed size records. A new value is never
+ *  written over its previous record, it is appended at the head of the log
+ *  instead and the record with the highest sequence number of a key is the
+ *  valid one. The head moves around the whole log (skipping slots that still
+ *  hold the current record of another key), so all cells wear evenly: with
+ *  the default layout every slot is written only once per 128 updates.
+ *
+ *  The current values are kept in RAM, so os_kvGet never touches the EEPROM.
+ *  os_kvSet only marks a key as dirty, the records are written byte by byte
+ *  from the EEPROM ready interrupt. Setting a key several times before it is
+ *  written produces a single record.
+ *
+ *  Record layout (little endian):
+ *    offset 0: sequence number   2 bytes
+ *    offset 2: key               0 .. OS_KV_MAX_KEYS - 1
+ *    offset 3: length            0 .. OS_KV_VALUE_SIZE
+ *    offset 4: value             OS_KV_VALUE_SIZE bytes
+ *    last byte: checksum         over all bytes before
+ *  A record that was interrupted by a reset has a wrong checksum and is
+ *  ignored, the previous record of its key stays valid.
+ */
+#ifndef _OS_KVSTORE_H
+#define _OS_KVSTORE_H
+#include "atmega644constants.h"
+#include "os_mem_drivers.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Number of keys, a key is just an index. Each one costs OS_KV_VALUE_SIZE + 2 bytes of RAM.
+#define OS_KV_MAX_KEYS 2
+
+//! Size of a record in the EEPROM and the maximum size of a value
+#define OS_KV_RECORD_SIZE 16
+#define OS_KV_VALUE_SIZE (OS_KV_RECORD_SIZE - 5)
+
+//! EEPROM area of the log (the whole EEPROM by default)
+#define OS_KV_LOG_START 0
+#define OS_KV_LOG_SLOTS (AVR_MEMORY_EEPROM / OS_KV_RECORD_SIZE)
+
+#if OS_KV_LOG_SLOTS <= OS_KV_MAX_KEYS
+#error "The key/value log needs more slots than keys"
+#endif
+
+//! Keys in use
+#define OS_KV_KEY_SNAKE_HIGHSCORES 0
+
+//! Reads the log and enables the EEPROM ready interrupt for pending writes
+void os_kvInit(void);
+
+//! Copies the value of a key into buffer, returns its length (0 if the key has no value)
+uint8_t os_kvGet(uint8_t key, void *buffer, uint8_t size);
+
+//! Changes the value of a key, it is written to the EEPROM in the background
+bool os_kvSet(uint8_t key, const void *value, uint8_t length);
+
+//! Whether there are values that are not written to the EEPROM yet
+bool os_kvPending(void);
+
+//! Waits (yielding) until all values are written
+void os_kvFlush(void);
+
+//! Byte access to the EEPROM, e.g. to dump the log (writes bypass the store)
+extern MemDriver intEEPROM__;
+#define intEEPROM (&intEEPROM__)
+
+#endif
@@ -10,7 +10,9 @@
 #include "defines.h" 
 #include "os_spi.h"
 #include <avr/io.h>
+#include <stddef.h>
 #include "os_scheduler.h"
+#include "os_core.h"
 
 void intSRAM_init(void) {
 	
@@ -45,56 +47,257 @@ MemDriver extSRAM__ = {
 	.read  = readSRAM_external,
 	.write = writeSRAM_external,
 	.start = EXTHEAP_MAP_START,
-	.size  = EXTHEAP_TOTAL_SIZE
+	.size  = EXTHEAP_TOTAL_SIZE,
+	.readBlock  = readBlockSRAM_external,
+	.writeBlock = writeBlockSRAM_external,
+	.fill       = fillSRAM_external
 };
 
+MemDriver extSRAMHigh__ = {
+	.init  = initSRAM_external,
+	.read  = readSRAM_externalHigh,
+	.write = writeSRAM_externalHigh,
+	.start = EXTHEAP2_MAP_START,
+	.size  = EXTHEAP2_TOTAL_SIZE,
+	.readBlock  = readBlockSRAM_externalHigh,
+	.writeBlock = writeBlockSRAM_externalHigh,
+	.fill       = fillSRAM_externalHigh
+};
+
+
 
+/* Chips am Bus, Fern-Adresse / EXTSRAM_CHIP_SIZE ist der Index. Weitere
+   Chips mit eigenem Chip Select anhaengen (nicht PORTB, siehe os_spi.h).
+   Mode 0, fcpu/2 */
+static SpiDevice const extSramDevices[] = {
+	{
+		.csPort = &EXTSRAM_CS_PORT,
+		.csMask = (1 << EXTSRAM_CS_PIN),
+		.spcr   = 0,
+		.spsr   = (1 << SPI2X)
+	},
+};
+
+#define EXTSRAM_CHIPS (sizeof(extSramDevices) / sizeof(extSramDevices[0]))
 
-void selectChip(){
-	EXTSRAM_CS_PORT &= ~(1 << EXTSRAM_CS_PIN);
+uint8_t extSRAM_getChipCount(void) {
+	return EXTSRAM_CHIPS;
 }
 
-void deselectChip(){
-	EXTSRAM_CS_PORT |= (1 << EXTSRAM_CS_PIN);
+MemFarAddr extSRAM_getFarSize(void) {
+	return EXTSRAM_CHIPS * EXTSRAM_CHIP_SIZE;
 }
 
 
 void initSRAM_external(void) {
 	os_spi_init();
-	selectChip();
-	os_spi_send(SRAM_CMD_WRMR);
-	os_spi_send(SRAM_MODE_BYTE);
-	deselectChip();
+	os_enterCriticalSection();
+	for (uint8_t chip = 0; chip < EXTSRAM_CHIPS; chip++) {
+		os_spi_initDevice(&extSramDevices[chip]);
+		os_spi_select(&extSramDevices[chip]);
+		// sequentiell: bei Bloecken zaehlt der Chip die Adresse selbst weiter
+		os_spi_send(SRAM_CMD_WRMR);
+		os_spi_send(SRAM_MODE_SEQUENTIAL);
+		os_spi_deselect(&extSramDevices[chip]);
+	}
+	os_leaveCriticalSection();
 }
 
-MemValue readSRAM_external(MemAddr addr) {
+// Index des Chips einer Fern-Adresse
+static uint8_t chipOf(MemFarAddr addr) {
+	uint8_t chip = addr / EXTSRAM_CHIP_SIZE;
+	if (chip >= EXTSRAM_CHIPS) {
+		os_error("FAR ADDR");
+		chip = 0;
+	}
+	return chip;
+}
+
+/* Beginnt eine Transaktion: Chip auswaehlen, Befehl und 24 bit Adresse senden
+   (17 bit davon zaehlen beim 23LC1024). Der Aufrufer ist in einer
+   kritischen Sektion, bis os_spi_deselect mit dem zurueckgegebenen Chip. */
+static SpiDevice const *beginSRAM_external(uint8_t command, MemFarAddr addr) {
+	SpiDevice const *device = &extSramDevices[chipOf(addr)];
+	addr %= EXTSRAM_CHIP_SIZE;
+	os_spi_select(device);
+	os_spi_send(command);
+	os_spi_send((MemValue)(addr >> 16));    // bank
+	os_spi_send((MemValue)(addr >> 8));     // high byte
+	os_spi_send((MemValue)addr);            // low byte
+	return device;
+}
+
+// Laenge bis zum Ende des Chips, dort werden Bloecke geteilt
+static uint16_t spanOnChip(MemFarAddr addr, uint16_t length) {
+	MemFarAddr rest = EXTSRAM_CHIP_SIZE - addr % EXTSRAM_CHIP_SIZE;
+	return rest < length ? (uint16_t)rest : length;
+}
+
+/* Block auf einem Chip direkt in einer kritischen Sektion. src NULL: fill
+   senden, dest NULL: Antwort verwerfen. */
+static void pollSRAM_external(uint8_t command, MemFarAddr addr, MemValue const *src, MemValue *dest, MemValue fill, uint16_t length) {
+	os_spi_waitIdle();
 	os_enterCriticalSection();
-	MemValue value;
-	selectChip();
-	// lese befehl senden
-	os_spi_send(SRAM_CMD_READ);
-	// send 16 bit address
-	os_spi_send(0x00);
-	os_spi_send((addr >> 8) & 0xFF);    // High byte
-	os_spi_send(addr & 0xFF);   // low byte
+	SpiDevice const *chip = beginSRAM_external(command, addr);
+	for (uint16_t i = 0; i < length; i++) {
+		MemValue in = os_spi_send(src ? src[i] : fill);
+		if (dest) {
+			dest[i] = in;
+		}
+	}
+	os_spi_deselect(chip);
+	os_leaveCriticalSection();
+}
+
+/* Block auf einem Chip ueber die Warteschlange, der Prozess gibt die CPU
+   ab, bis er uebertragen ist. Mit langsamerem Takt: bei fcpu/2 dauert ein
+   Byte kuerzer als der ISR, bei fcpu/16 bleibt gut die Haelfte der CPU
+   fuer andere Prozesse. */
+static void queueSRAM_external(uint8_t command, MemFarAddr addr, MemValue const *src, MemValue *dest, MemValue fill, uint16_t length) {
+	SpiDevice device = extSramDevices[chipOf(addr)];
+	device.spcr = EXTSRAM_QUEUE_SPCR;
+	device.spsr = EXTSRAM_QUEUE_SPSR;
+	addr %= EXTSRAM_CHIP_SIZE;
+	uint8_t header[4] = {command, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
+	SpiTransfer transfer = {
+		.device       = &device,
+		.header       = header,
+		.headerLength = sizeof(header),
+		.tx           = src,
+		.rx           = dest,
+		.fill         = fill,
+		.length       = length,
+		.callback     = NULL
+	};
+	os_spi_transfer(&transfer);
+}
+
+// Teilt an Chipgrenzen, lange Bloecke ueber die Warteschlange, wenn der Prozess warten kann
+static void blockSRAM_far(uint8_t command, MemFarAddr addr, MemValue const *src, MemValue *dest, MemValue fill, uint16_t length) {
+	while (length) {
+		uint16_t n = spanOnChip(addr, length);
+		if (n >= EXTSRAM_QUEUE_MIN && os_spi_canYield()) {
+			queueSRAM_external(command, addr, src, dest, fill, n);
+		} else {
+			pollSRAM_external(command, addr, src, dest, fill, n);
+		}
+		addr += n;
+		if (src) {
+			src += n;
+		}
+		if (dest) {
+			dest += n;
+		}
+		length -= n;
+	}
+}
+
+// Eine kritische Sektion pro Transaktion, os_spi_send sperrt nicht selbst
+MemValue readSRAM_far(MemFarAddr addr) {
+	os_spi_waitIdle();
+	os_enterCriticalSection();
+	SpiDevice const *chip = beginSRAM_external(SRAM_CMD_READ, addr);
 	// bekomme die daten
-	value = os_spi_receive();
-	deselectChip();
+	MemValue value = os_spi_receive();
+	os_spi_deselect(chip);
 	os_leaveCriticalSection();
 	return value;
 }
 
-void writeSRAM_external(MemAddr addr, MemValue value) {
+void writeSRAM_far(MemFarAddr addr, MemValue value) {
+	os_spi_waitIdle();
 	os_enterCriticalSection();
-	selectChip();
-	// lese befehl senden
-	os_spi_send(SRAM_CMD_WRITE);
-	// send 16 bit address
-	os_spi_send(0x00);
-	os_spi_send((MemValue)(addr >> 8));     // high byte
-	os_spi_send((MemValue)addr);     // low byte
+	SpiDevice const *chip = beginSRAM_external(SRAM_CMD_WRITE, addr);
 	// Sendende daten
 	os_spi_send(value);
-	deselectChip();
+	os_spi_deselect(chip);
 	os_leaveCriticalSection();
 }
+
+void readBlockSRAM_far(MemFarAddr addr, MemValue *dest, uint16_t length) {
+	blockSRAM_far(SRAM_CMD_READ, addr, NULL, dest, 0xFF, length);
+}
+
+void writeBlockSRAM_far(MemFarAddr addr, MemValue const *src, uint16_t length) {
+	blockSRAM_far(SRAM_CMD_WRITE, addr, src, NULL, 0, length);
+}
+
+void fillSRAM_far(MemFarAddr addr, MemValue value, uint16_t length) {
+	blockSRAM_far(SRAM_CMD_WRITE, addr, NULL, NULL, value, length);
+}
+
+
+// extSRAM: erste 64 KB des ersten Chips
+MemValue readSRAM_external(MemAddr addr) {
+	return readSRAM_far(addr);
+}
+
+void writeSRAM_external(MemAddr addr, MemValue value) {
+	writeSRAM_far(addr, value);
+}
+
+void readBlockSRAM_external(MemAddr addr, MemValue *dest, uint16_t length) {
+	readBlockSRAM_far(addr, dest, length);
+}
+
+void writeBlockSRAM_external(MemAddr addr, MemValue const *src, uint16_t length) {
+	writeBlockSRAM_far(addr, src, length);
+}
+
+void fillSRAM_external(MemAddr addr, MemValue value, uint16_t length) {
+	fillSRAM_far(addr, value, length);
+}
+
+
+// extSRAMHigh: zweite 64 KB des ersten Chips
+MemValue readSRAM_externalHigh(MemAddr addr) {
+	return readSRAM_far(EXTSRAM_BANK_SIZE + addr);
+}
+
+void writeSRAM_externalHigh(MemAddr addr, MemValue value) {
+	writeSRAM_far(EXTSRAM_BANK_SIZE + addr, value);
+}
+
+void readBlockSRAM_externalHigh(MemAddr addr, MemValue *dest, uint16_t length) {
+	readBlockSRAM_far(EXTSRAM_BANK_SIZE + addr, dest, length);
+}
+
+void writeBlockSRAM_externalHigh(MemAddr addr, MemValue const *src, uint16_t length) {
+	writeBlockSRAM_far(EXTSRAM_BANK_SIZE + addr, src, length);
+}
+
+void fillSRAM_externalHigh(MemAddr addr, MemValue value, uint16_t length) {
+	fillSRAM_far(EXTSRAM_BANK_SIZE + addr, value, length);
+}
+
+
+// Ohne Blockfunktion des Treibers byteweise
+void os_memRead(MemDriver const *driver, MemAddr addr, MemValue *dest, uint16_t length) {
+	if (driver->readBlock) {
+		driver->readBlock(addr, dest, length);
+		return;
+	}
+	for (uint16_t i = 0; i < length; i++) {
+		dest[i] = driver->read(addr + i);
+	}
+}
+
+void os_memWrite(MemDriver const *driver, MemAddr addr, MemValue const *src, uint16_t length) {
+	if (driver->writeBlock) {
+		driver->writeBlock(addr, src, length);
+		return;
+	}
+	for (uint16_t i = 0; i < length; i++) {
+		driver->write(addr + i, src[i]);
+	}
+}
+
+void os_memFill(MemDriver const *driver, MemAddr addr, MemValue value, uint16_t length) {
+	if (driver->fill) {
+		driver->fill(addr, value, length);
+		return;
+	}
+	for (uint16_t i = 0; i < length; i++) {
+		driver->write(addr + i, value);
+	}
+}
@@ -14,6 +14,8 @@
 
 typedef uint16_t MemAddr;
 typedef uint8_t  MemValue;
+// Adresse im ganzen externen SRAM, ab EXTSRAM_CHIP_SIZE der naechste Chip
+typedef uint32_t MemFarAddr;
 
 
 typedef struct MemDriver {
@@ -22,8 +24,21 @@ typedef struct MemDriver {
 	void     (*write)(MemAddr addr, MemValue value);
 	MemAddr const start;
 	uint16_t const size;
+	// Optional (NULL): mehrere Bytes in einer Transaktion, siehe os_memRead usw.
+	void     (*readBlock)(MemAddr addr, MemValue *dest, uint16_t length);
+	void     (*writeBlock)(MemAddr addr, MemValue const *src, uint16_t length);
+	void     (*fill)(MemAddr addr, MemValue value, uint16_t length);
 } MemDriver;
 
+//! Reads length bytes from addr on, in one transaction if the driver supports it
+void os_memRead(MemDriver const *driver, MemAddr addr, MemValue *dest, uint16_t length);
+
+//! Writes length bytes from addr on, in one transaction if the driver supports it
+void os_memWrite(MemDriver const *driver, MemAddr addr, MemValue const *src, uint16_t length);
+
+//! Sets length bytes from addr on to value, in one transaction if the driver supports it
+void os_memFill(MemDriver const *driver, MemAddr addr, MemValue value, uint16_t length);
+
 
 extern MemDriver intSRAM__;
 #define intSRAM (&intSRAM__)
@@ -34,10 +49,49 @@ MemValue readSRAM_external(MemAddr addr);
 
 void writeSRAM_external(MemAddr addr, MemValue value);
 
+void readBlockSRAM_external(MemAddr addr, MemValue *dest, uint16_t length);
+
+void writeBlockSRAM_external(MemAddr addr, MemValue const *src, uint16_t length);
+
+void fillSRAM_external(MemAddr addr, MemValue value, uint16_t length);
+
+
+// Zweite Haelfte des ersten 23LC1024 (Fern-Adresse EXTSRAM_BANK_SIZE + addr)
+MemValue readSRAM_externalHigh(MemAddr addr);
+
+void writeSRAM_externalHigh(MemAddr addr, MemValue value);
+
+void readBlockSRAM_externalHigh(MemAddr addr, MemValue *dest, uint16_t length);
+
+void writeBlockSRAM_externalHigh(MemAddr addr, MemValue const *src, uint16_t length);
+
+void fillSRAM_externalHigh(MemAddr addr, MemValue value, uint16_t length);
+
+
+/* Zugriff mit Fern-Adressen ueber alle Chips, z.B. fuer Logdaten ausserhalb
+   der Heaps. Bloecke ueber eine Chipgrenze werden geteilt. */
+MemValue readSRAM_far(MemFarAddr addr);
+
+void writeSRAM_far(MemFarAddr addr, MemValue value);
+
+void readBlockSRAM_far(MemFarAddr addr, MemValue *dest, uint16_t length);
+
+void writeBlockSRAM_far(MemFarAddr addr, MemValue const *src, uint16_t length);
+
+void fillSRAM_far(MemFarAddr addr, MemValue value, uint16_t length);
+
+uint8_t extSRAM_getChipCount(void);
+
+// Groesse aller Chips zusammen
+MemFarAddr extSRAM_getFarSize(void);
+
 
 extern MemDriver extSRAM__;
 #define extSRAM (&extSRAM__)
 
+extern MemDriver extSRAMHigh__;
+#define extSRAMHigh (&extSRAMHigh__)
+
 
 
 // 23LC1024 befehle
@@ -45,6 +99,14 @@ extern MemDriver extSRAM__;
 #define SRAM_CMD_WRITE  0x02
 #define SRAM_CMD_WRMR   0x01
 #define SRAM_MODE_BYTE  0x00
+#define SRAM_MODE_SEQUENTIAL 0x40   // Adresse zaehlt weiter, auch ueber Seitengrenzen
+#define EXTSRAM_CHIP_SIZE 0x20000ul   // 128 KB
+#define EXTSRAM_BANK_SIZE 0x10000ul   // was ein MemAddr erreicht
+
+// Bloecke ab dieser Laenge ueber die SPI-Warteschlange mit fcpu/16, kuerzere direkt mit fcpu/2
+#define EXTSRAM_QUEUE_MIN  64
+#define EXTSRAM_QUEUE_SPCR (1 << SPR0)
+#define EXTSRAM_QUEUE_SPSR 0
 
 // CS-Pin 
 #define EXTSRAM_CS_PORT PORTB
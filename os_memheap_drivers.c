@@ -9,6 +9,14 @@
 #include "os_memheap_drivers.h"
 #include "defines.h"      
 #include "led_draw.h"
+#include "os_memory.h"
+
+#include <avr/pgmspace.h>
+
+// Namen im Flash, die Task-Manager-Seiten lesen sie mit lcd_writeProgString
+static char const PROGMEM intHeapName[] = "intHeap";
+static char const PROGMEM extHeapName[] = "extHeap";
+static char const PROGMEM extHeap2Name[] = "extHeap2";
 
 Heap intHeap__ = {
 	.driver     = intSRAM,
@@ -17,34 +25,38 @@ Heap intHeap__ = {
 	.useStart   = HEAP_USE_START,
 	.useSize    = HEAP_USE_SIZE,
 	.allocStrat = OS_MEM_FIRST,
-	.name       = "intHeap"
+	.name       = intHeapName
 };
 
+/* Alle Heaps, der Index gilt fuer os_lookupHeap. Es gibt kein automatisches
+   Ausweichen auf extHeap: Chunks im externen SRAM sind nur ueber den Treiber
+   erreichbar, die Nutzer des intHeap (Snake, Stream) brauchen Zeiger. */
+static Heap *const heaps[] = {
+	&intHeap__,
+	&extHeap__,
+	&extHeap2__
+};
+
+#define HEAP_COUNT (sizeof(heaps) / sizeof(heaps[0]))
+
 void os_initHeaps(void) {
 	draw_letter('u', 5, 19, COLOR_YELLOW, false, false);
-	 // Interner Heap
-	intHeap__.driver->init();
-	for (size_t i = 0; i < intHeap__.mapSize; ++i) {
-		intHeap__.driver->write(intHeap__.mapStart + i, (MemValue)0x00);
+	for (uint8_t i = 0; i < HEAP_COUNT; ++i) {
+		Heap *heap = heaps[i];
+		heap->driver->init();
+		// Map leeren, bei externen Heaps in einer Transaktion
+		os_memFill(heap->driver, heap->mapStart, 0x00, heap->mapSize);
+		os_resetHeapStats(heap);
 	}
-	
-	// Externer Heap:
-	extHeap__.driver->init();
-	for (size_t i = 0; i < extHeap__.mapSize; ++i) {
-		extHeap__.driver->write(extHeap__.mapStart + i, (MemValue)0x00);
-	}
-	
 }
 
 uint8_t os_getHeapListLength(void) {
-	return 1;  
+	return HEAP_COUNT;
 }
 
 Heap* os_lookupHeap(uint8_t index) {
-	if (index == 0) {
-		return &intHeap__;
-		} else if (index == 1) {
-		return &extHeap__;
+	if (index < HEAP_COUNT) {
+		return heaps[index];
 	}
 	return 0;
 }
@@ -58,5 +70,15 @@ Heap extHeap__ = {
 	.useStart   = EXTHEAP_USE_START,
 	.useSize    = EXTHEAP_USE_SIZE,
 	.allocStrat = OS_MEM_FIRST,
-	.name       = "extHeap"
+	.name       = extHeapName
+};
+
+Heap extHeap2__ = {
+	.driver     = extSRAMHigh,
+	.mapStart   = EXTHEAP2_MAP_START,
+	.mapSize    = EXTHEAP2_MAP_SIZE,
+	.useStart   = EXTHEAP2_USE_START,
+	.useSize    = EXTHEAP2_USE_SIZE,
+	.allocStrat = OS_MEM_FIRST,
+	.name       = extHeap2Name
 };
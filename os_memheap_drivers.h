@@ -11,6 +11,7 @@
 #include "defines.h"
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include "os_mem_drivers.h"   
 
 //#define MAX_NUMBER_OF_PROCESSES 8
@@ -24,6 +25,19 @@ typedef enum AllocStrategy {
 } AllocStrategy;
 
 
+// Statistik eines Heaps, wird in os_malloc, os_free und os_realloc mitgezaehlt
+typedef struct HeapStats {
+	uint16_t used;              // belegte Bytes
+	uint16_t peakUsed;          // hoechster Wert von used
+	uint16_t chunks;            // Anzahl belegter Chunks
+	uint16_t failures;          // fehlgeschlagene Allokationen
+	uint16_t largestFree;       // groesster freier Block, gilt nur mit largestFreeValid
+	bool largestFreeValid;      // wird bei jeder Aenderung geloescht, os_getHeapStats sucht dann neu
+	uint16_t changes;           // zaehlt Aenderungen, fuer die Suche ohne kritische Sektion (16 Bit:
+	                            // waehrend der langen Suche im extHeap laeuft er nicht ganz herum)
+} HeapStats;
+
+
 typedef struct Heap {
 	const MemDriver* driver;      
 	MemAddr mapStart;    
@@ -33,7 +47,8 @@ typedef struct Heap {
 	AllocStrategy allocStrat;
 	MemAddr allocFrameStart[MAX_NUMBER_OF_PROCESSES];
 	MemAddr allocFrameEnd  [MAX_NUMBER_OF_PROCESSES];  
-	const char* name;        
+	const char* name;           // im Flash
+	HeapStats stats;
 } Heap;
 
 
@@ -43,6 +58,7 @@ extern Heap intHeap__;
 
 void os_initHeaps(void);
 
+// Anzahl der Heaps, os_lookupHeap liefert sie fuer 0 bis Anzahl - 1
 uint8_t os_getHeapListLength(void);
 
 Heap* os_lookupHeap(uint8_t index);
@@ -52,6 +68,10 @@ Heap* os_lookupHeap(uint8_t index);
 extern Heap extHeap__;
 #define extHeap (&extHeap__)
 
+// Zweite Haelfte des 23LC1024
+extern Heap extHeap2__;
+#define extHeap2 (&extHeap2__)
+
 
 
 
@@ -13,10 +13,26 @@
 #include "os_scheduler.h"  
 #include "os_process.h"
 #include "os_core.h"
+#include "os_trace.h"
 
 
 
 
+// Wird nach jeder nderung der Map aufgerufen, z.B. von der Heap-Ansicht auf dem Panel
+static HeapHook *heapHook = NULL;
+
+void os_setHeapHook(HeapHook *hook){
+	os_enterCriticalSection();
+	heapHook = hook;
+	os_leaveCriticalSection();
+}
+
+static void notifyHeapHook(Heap const* heap, MemAddr addr, uint16_t length, uint8_t owner){
+	if (heapHook && length) {
+		heapHook(heap, addr, length, owner);
+	}
+}
+
 MemAddr mapByteAddr(Heap const* heap, MemAddr addr) { 
 	
 	uint16_t offset = addr - heap->useStart;
@@ -77,8 +93,114 @@ void os_setMapEntry(Heap const* heap, MemAddr addr, uint8_t value){
 	heap->driver->write(mapAddr, combined);
 }
 
+// Statistik: bytes mehr belegt, chunks neue Chunks
+static void statsGrow(Heap* heap, uint16_t bytes, uint8_t chunks){
+	heap->stats.used += bytes;
+	heap->stats.chunks += chunks;
+	if (heap->stats.used > heap->stats.peakUsed) {
+		heap->stats.peakUsed = heap->stats.used;
+	}
+	heap->stats.largestFreeValid = false;
+	heap->stats.changes++;
+}
+
+static void statsShrink(Heap* heap, uint16_t bytes, uint8_t chunks){
+	heap->stats.used -= bytes;
+	heap->stats.chunks -= chunks;
+	heap->stats.largestFreeValid = false;
+	heap->stats.changes++;
+}
+
+// Setzt length Eintraege ab addr, die vollen Map-Bytes dazwischen in einer Transaktion
+static void setMapRange(Heap const* heap, MemAddr addr, uint16_t length, uint8_t value){
+	MemAddr heapEnd = heap->useStart + heap->useSize;
+	if (addr + length > heapEnd) {
+		length = heapEnd - addr;
+	}
+	// halbes Byte am Anfang
+	if (length && !isHigh(heap, addr)) {
+		os_setMapEntry(heap, addr++, value);
+		--length;
+	}
+	uint16_t bytes = length / 2;
+	if (bytes) {
+		os_memFill(heap->driver, mapByteAddr(heap, addr), (MemValue)((value << 4) | (value & 0x0F)), bytes);
+		addr += bytes * 2;
+	}
+	// halbes Byte am Ende
+	if (length & 1) {
+		os_setMapEntry(heap, addr, value);
+	}
+}
+
+
+
+
+// Laengste Folge freier Map-Eintraege, die Map wird in Bloecken gelesen
+static uint16_t largestFreeRun(Heap const* heap){
+	MemValue buffer[16];
+	uint16_t run = 0;
+	uint16_t largest = 0;
+	uint16_t entries = heap->useSize;
+	for (MemAddr i = 0; i < heap->mapSize && entries; i += sizeof(buffer)) {
+		uint16_t n = heap->mapSize - i < sizeof(buffer) ? heap->mapSize - i : sizeof(buffer);
+		os_memRead(heap->driver, heap->mapStart + i, buffer, n);
+		// oberes Nibble zuerst, siehe isHigh
+		for (uint16_t j = 0; j < 2 * n && entries; ++j, --entries) {
+			uint8_t entry = (j & 1) ? buffer[j / 2] & 0x0F : buffer[j / 2] >> 4;
+			if (entry == MEMORY_FREE) {
+				++run;
+			} else {
+				if (run > largest) largest = run;
+				run = 0;
+			}
+		}
+	}
+	return run > largest ? run : largest;
+}
+
+/* Loescht Map und Daten in einer kritischen Sektion, damit kein anderer
+   Prozess eine halb geloeschte Map sieht. */
+void os_eraseHeap(Heap* heap){
+	os_enterCriticalSection();
+	os_memFill(heap->driver, heap->mapStart, 0, heap->mapSize);
+	os_memFill(heap->driver, heap->useStart, 0, heap->useSize);
+	for (ProcessID pid = 0; pid < MAX_NUMBER_OF_PROCESSES; ++pid) {
+		heap->allocFrameStart[pid] = heap->useStart + heap->useSize;
+		heap->allocFrameEnd  [pid] = heap->useStart;
+	}
+	heap->stats = (HeapStats){.changes = heap->stats.changes + 1};
+	notifyHeapHook(heap, heap->useStart, heap->useSize, MEMORY_FREE);
+	os_leaveCriticalSection();
+}
 
+void os_resetHeapStats(Heap* heap){
+	os_enterCriticalSection();
+	heap->stats = (HeapStats){.changes = heap->stats.changes + 1};
+	os_leaveCriticalSection();
+}
 
+/* Kopiert die Statistik. Nur der groesste freie Block wird gesucht, und nur
+   wenn sich der Heap seit der letzten Suche geaendert hat. Die Suche laeuft
+   ohne kritische Sektion, aendert sich der Heap waehrenddessen, ist das
+   Ergebnis nur eine Schaetzung und largestFreeValid bleibt false. */
+void os_getHeapStats(Heap* heap, HeapStats* stats){
+	os_enterCriticalSection();
+	bool valid = heap->stats.largestFreeValid;
+	uint16_t changes = heap->stats.changes;
+	os_leaveCriticalSection();
+	uint16_t largest = valid ? 0 : largestFreeRun(heap);
+	os_enterCriticalSection();
+	if (!valid && heap->stats.changes == changes) {
+		heap->stats.largestFree = largest;
+		heap->stats.largestFreeValid = true;
+	}
+	*stats = heap->stats;
+	if (!valid) {
+		stats->largestFree = largest;
+	}
+	os_leaveCriticalSection();
+}
 
 void frameExtend(Heap *heap, ProcessID pid, MemAddr start, uint16_t len){
 	if (start < heap->allocFrameStart[pid])
@@ -113,11 +235,14 @@ void frameShrinkIfNeeded(Heap *heap, ProcessID pid){
 MemAddr os_malloc(Heap* heap, uint16_t size){
 	if (size == 0) return 0;
 	
-	if (size > heap->useSize) {
+	os_enterCriticalSection();
+	
+	// passt sicher nicht, ohne Suche ablehnen
+	if (size > heap->useSize - heap->stats.used) {
+		heap->stats.failures++;
+		os_leaveCriticalSection();
 		return 0;
 	}
-
-	os_enterCriticalSection();
 	
 	MemAddr addr = 0;
 	switch (heap->allocStrat) {
@@ -130,19 +255,19 @@ MemAddr os_malloc(Heap* heap, uint16_t size){
 	if (addr) {
 		
 		if (addr < heap->useStart || addr >= heap->useStart + heap->useSize) {
+			heap->stats.failures++;
 			os_leaveCriticalSection();
 			return 0;
 		}
 		
 		uint8_t pid = os_getCurrentProc();
 		os_setMapEntry(heap, addr, pid);
-		
-		for (uint16_t i = 1; i < size; ++i) {
-			
-			if (addr + i < heap->useStart + heap->useSize) {
-				os_setMapEntry(heap, addr + i, 0xF);
-			}
-		}
+		setMapRange(heap, addr + 1, size - 1, 0xF);
+		notifyHeapHook(heap, addr, size, pid);
+		os_trace(OS_TRACE_MALLOC, size);
+		statsGrow(heap, size, 1);
+	} else {
+		heap->stats.failures++;
 	}
 	ProcessID pid = os_getCurrentProc();
 	frameExtend(heap, pid, addr, size);
@@ -170,17 +295,28 @@ void os_free(Heap* heap, MemAddr addr){
 	while(addr > heap->useStart && os_getMapEntry(heap, addr) == 0xF) {
 		--addr;
 	}
-	// erste nibble in map lschen
-	os_setMapEntry(heap, addr, 0);
-	heap->driver->write(addr, 0);
-	// folgende nibble lschen
+	// ende des chunks suchen
 	MemAddr heapEnd = heap->useStart + heap->useSize;
 	MemAddr p = addr + 1;
 	while(p < heapEnd && os_getMapEntry(heap, p) == 0xF) {
-		os_setMapEntry(heap, p, 0);
-		heap->driver->write(p, 0);
 		++p;
 	}
+	// daten zuerst lschen, ohne kritische sektion: der chunk ist noch
+	// belegt, lange chunks gehen ber die SPI-warteschlange
+	uint8_t owner = os_getMapEntry(heap, addr);
+	os_leaveCriticalSection();
+	os_memFill(heap->driver, addr, 0, p - addr);
+	os_enterCriticalSection();
+	// inzwischen von einem anderen prozess freigegeben
+	if (os_getMapEntry(heap, addr) != owner) {
+		os_leaveCriticalSection();
+		return;
+	}
+	// nibbles in map lschen, eine transaktion
+	setMapRange(heap, addr, p - addr, 0);
+	statsShrink(heap, p - addr, 1);
+	notifyHeapHook(heap, addr, p - addr, MEMORY_FREE);
+	os_trace(OS_TRACE_FREE, p - addr);
 	
 	uint16_t size = os_getChunkSize(heap, addr);
 	ProcessID pid = os_getCurrentProc();
@@ -344,6 +480,8 @@ MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size){
 			os_setMapEntry(heap, addr + i, 0);
 			heap->driver->write(addr + i, 0);
 		}
+		notifyHeapHook(heap, addr + size, oldSize - size, MEMORY_FREE);
+		statsShrink(heap, oldSize - size, 0);
 
 		if (addr + oldSize >= heap->allocFrameEnd[pid]) {
 			frameShrinkIfNeeded(heap, pid);
@@ -374,6 +512,8 @@ MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size){
 		for (uint16_t i = 0; i < difference; ++i) {
 			os_setMapEntry(heap, addr + oldSize + i, 0xF);
 		}
+		notifyHeapHook(heap, addr + oldSize, difference, pid);
+		statsGrow(heap, difference, 0);
 		frameExtend(heap, pid, addr, size);
 		os_leaveCriticalSection();
 		return addr;
@@ -392,7 +532,12 @@ MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size){
 		for (uint16_t i = 0; i < size; ++i) {
 			os_setMapEntry(heap, newStart + i, (i == 0) ? pid : 0xF);
 		}
+		notifyHeapHook(heap, newStart, size, pid);
+		if (newStart + size < addr + oldSize) {
+			notifyHeapHook(heap, newStart + size, addr + oldSize - (newStart + size), MEMORY_FREE);
+		}
 
+		statsGrow(heap, difference, 0);
 		addr = newStart;
 		frameExtend(heap, pid, addr, size);
 		os_leaveCriticalSection();
@@ -415,7 +560,12 @@ MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size){
 		for (uint16_t i = 0; i < size; ++i) {
 			os_setMapEntry(heap, newStartAddr + i, (i == 0) ? pid : 0xF);
 		}
+		notifyHeapHook(heap, newStartAddr, size, pid);
+		if (newStartAddr + size < addr + oldSize) {
+			notifyHeapHook(heap, newStartAddr + size, addr + oldSize - (newStartAddr + size), MEMORY_FREE);
+		}
 
+		statsGrow(heap, difference, 0);
 		addr = newStartAddr;
 		frameExtend(heap, pid, addr, size);
 		os_leaveCriticalSection();
@@ -493,6 +643,7 @@ MemAddr os_sh_malloc(Heap* heap, uint16_t size){
 		for(MemAddr i = 1; i < size; ++i){
 			os_setMapEntry(heap, addr + i, MEMORY_SHARED_FOLLOWS);
 		}
+		notifyHeapHook(heap, addr, size, MEMORY_SHARED_CLOSED);
 	}
 	os_leaveCriticalSection();
 	return addr;
@@ -524,6 +675,8 @@ void os_sh_free(Heap* heap, MemAddr* ptr){
 	for(uint16_t i = 0; i < size; ++i){
 		os_setMapEntry(heap, addr + i, MEMORY_FREE);
 	}
+	notifyHeapHook(heap, addr, size, MEMORY_FREE);
+	statsShrink(heap, size, 1);
 	os_leaveCriticalSection();
 	*ptr = 0;
 }
@@ -628,9 +781,7 @@ void os_sh_write(Heap const* heap, MemAddr const* ptr, uint16_t offset, MemValue
 		os_sh_close(heap, base);
 		return;
 	}
-	for(uint16_t i = 0; i < length; ++i){
-		heap->driver->write(base + offset + i, dataSrc[i]);
-	}
+	os_memWrite(heap->driver, base + offset, dataSrc, length);
 	os_sh_close(heap, base);
 }
 
@@ -647,9 +798,7 @@ void os_sh_read(Heap const* heap, MemAddr const* ptr, uint16_t offset, MemValue*
 		os_sh_close(heap, base);
 		return;
 	}
-	for(uint16_t i = 0; i < length; ++i){
-		dataDest[i] = heap->driver->read(base + offset + i);
-	}
+	os_memRead(heap->driver, base + offset, dataDest, length);
 	os_sh_close(heap, base);
 	
 }
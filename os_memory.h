@@ -41,6 +41,17 @@ AllocStrategy os_getAllocationStrategy(Heap const* heap);
 void os_freeProcessMemory(Heap* heap, ProcessID pid);
 MemAddr os_realloc(Heap* heap, MemAddr addr, uint16_t size);
 
+// Statistik, siehe HeapStats
+void os_getHeapStats(Heap* heap, HeapStats* stats);
+void os_resetHeapStats(Heap* heap);
+
+// Gibt alle Chunks frei und loescht Map und Daten
+void os_eraseHeap(Heap* heap);
+
+// Wird aufgerufen, nachdem length Map-Einträge ab addr owner gehören (Prozess, geteilt oder MEMORY_FREE)
+typedef void HeapHook(Heap const* heap, MemAddr addr, uint16_t length, uint8_t owner);
+void os_setHeapHook(HeapHook *hook);
+
 
 /////////////////////////////////////////////////////////
 
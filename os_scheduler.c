@@ -10,10 +10,13 @@
 #include "os_scheduler.h"
 
 #include "lcd.h"
+#include "led_stream.h"
 #include "os_core.h"
 #include "os_input.h"
 #include "os_scheduling_strategies.h"
+#include "os_spi.h"
 #include "os_taskman.h"
+#include "os_trace.h"
 #include "util.h"
 #include "os_memheap_drivers.h"
 #include "os_memory.h"
@@ -49,6 +52,9 @@ SchedulingStrategy schedulingStrategy;
 uint8_t criticalSectionCount = 0;
 //#warning IMPLEMENT STH. HERE
 
+//! Prozess des Taskmanagers, INVALID_PROCESS solange er nicht luft
+static ProcessID taskManProc = INVALID_PROCESS;
+
 //----------------------------------------------------------------------------
 // Private function declarations
 //----------------------------------------------------------------------------
@@ -57,6 +63,12 @@ uint8_t criticalSectionCount = 0;
 ISR(TIMER2_COMPA_vect)
 __attribute__((naked));
 
+//! Program of the task manager process
+void taskMan(void);
+
+//! Prepares the slot of a new process
+static void os_setupProcess(ProcessID pid, Program *program, Priority priority);
+
 //----------------------------------------------------------------------------
 // Function definitions
 //----------------------------------------------------------------------------
@@ -77,14 +89,21 @@ ISR(TIMER2_COMPA_vect) {
 
 	// 34: auf ISR-Stack wechseln
 	SP = BOTTOM_OF_ISR_STACK;
-
-	// Taskmanager Enter+ESC
-	{
-		uint8_t input = os_getInput();
-		if ((input & ((1<<0)|(1<<3))) == ((1<<0)|(1<<3))) {
-			os_taskManMain();
-			os_waitForNoInput();
+	ProcessID previousProc = currentProc;
+
+	// Taskmanager Enter+ESC (ESC lang, solange das Panel Enter belegt),
+	// erkannt vom Pin-Change-Interrupt der Taster.
+	// Er luft als eigener Prozess, die anderen laufen whrenddessen weiter.
+	// Ohne freien Prozess-Slot (z.B. Snake geteilt) leiht er sich den Slot
+	// von idle, dessen Kontext eben gesichert wurde; idle beginnt danach neu.
+	bool taskManWoken = false;
+	if (os_takeInputChord() && taskManProc == INVALID_PROCESS) {
+		taskManProc = os_exec(taskMan, TASKMAN_PRIORITY);
+		if (taskManProc == INVALID_PROCESS) {
+			taskManProc = 0;
+			os_setupProcess(taskManProc, taskMan, TASKMAN_PRIORITY);
 		}
+		taskManWoken = true;
 	}
 
 	// 5: aktuellen Prozess auf READY setzen
@@ -96,9 +115,15 @@ ISR(TIMER2_COMPA_vect) {
 	
 	os_processes[currentProc].checksum = os_getStackChecksum(currentProc);
 
-	// 6: nchsten Prozess auswhlen
+	// 6: nchsten Prozess auswhlen, ein gerade gestarteter Taskmanager sofort
 
-	if (schedulingStrategy == OS_SS_EVEN) {
+	if (taskManWoken) {
+		currentProc = taskManProc;
+		} else if (taskManProc != INVALID_PROCESS && previousProc != taskManProc && os_processes[taskManProc].state == OS_PS_READY) {
+		// der offene Taskmanager bekommt jede zweite Zeitscheibe, auch im Slot
+		// von idle und gegen einen Prozess, der nie abgibt (sonst wre er nicht zu beenden)
+		currentProc = taskManProc;
+		} else if (schedulingStrategy == OS_SS_EVEN) {
 		currentProc = os_Scheduler_Even(os_processes, currentProc);
 		} else if (schedulingStrategy == OS_SS_ROUND_ROBIN) {
 		currentProc = os_Scheduler_RoundRobin(os_processes, currentProc);
@@ -150,6 +175,9 @@ ISR(TIMER2_COMPA_vect) {
 	// 7: ndere stand zu running
 	
 	os_processes[os_getCurrentProc()].state = OS_PS_RUNNING;
+	if (currentProc != previousProc) {
+		os_trace(OS_TRACE_SWITCH, previousProc);
+	}
 
 	// 8: auf dessen Stack zurckwechseln
 	SP = os_processes[os_getCurrentProc()].sp.as_int;
@@ -166,13 +194,35 @@ ISR(TIMER2_COMPA_vect) {
 void idle(void){
 	
 	while (1) {
-		lcd_writeProgString(PSTR("....."));
+		// das LCD gehrt gerade dem Taskmanager
+		if (!os_taskManOpen()) {
+			lcd_writeProgString(PSTR("....."));
+		}
 		delayMs(DEFAULT_OUTPUT_DELAY);
 	}
 	
 //#warning IMPLEMENT STH. HERE
 }
 
+/*!
+ *  The task manager as a process. It is started by the scheduler when the
+ *  buttons Enter and ESC are pressed together (ESC is held for
+ *  OS_INPUT_CHORD_HOLD_MS while the LED panel uses Enter) and ends when it
+ *  is left. If every slot is taken it runs in the slot of idle and turns
+ *  back into idle at the end, so it can always be opened.
+ */
+void taskMan(void){
+	os_taskManMain();
+	os_waitForNoInput();
+	// ab hier darf der Prozess wieder beendet werden (os_dispatcher)
+	taskManProc = INVALID_PROCESS;
+	// im geliehenen Slot von idle: wieder idle werden, Prozess 0 endet nie
+	if (os_getCurrentProc() == 0) {
+		os_processes[0].priority = DEFAULT_PRIORITY;
+		idle();
+	}
+}
+
 /*!
  *  This function is used to register the given program for execution.
  *  A stack will be provided if the process limit has not yet been reached.
@@ -204,6 +254,21 @@ ProcessID os_exec(Program *program, Priority priority) {
 		return INVALID_PROCESS;
 	}
 
+	os_setupProcess(pid, program, priority);
+	os_leaveCriticalSection();
+	
+	return pid;
+	
+//#error IMPLEMENT STH. HERE
+}
+
+/*!
+ *  Prepares a slot for a program: state, priority and a fresh stack that
+ *  starts in os_dispatcher. Whatever ran in the slot before is lost, so
+ *  it must be unused or (for the task manager) idle with its context
+ *  saved. Only within a critical section.
+ */
+static void os_setupProcess(ProcessID pid, Program *program, Priority priority) {
 	// Programmzeiger, Zustand und Prioritt speichern
 	os_processes[pid].program  = program;
 	os_processes[pid].state    = OS_PS_READY;
@@ -229,11 +294,7 @@ ProcessID os_exec(Program *program, Priority priority) {
 	
 	
 	os_processes[pid].checksum = os_getStackChecksum(pid);
-	os_leaveCriticalSection();
-	
-	return pid;
-	
-//#error IMPLEMENT STH. HERE
+	os_trace(OS_TRACE_EXEC, pid | (uint16_t)priority << 8);
 }
 
 	
@@ -321,51 +382,18 @@ SchedulingStrategy os_getSchedulingStrategy(void) {
 }
 
 /*!
- *  Enters a critical code section by disabling the scheduler if needed.
- *  This function stores the nesting depth of critical sections of the current
- *  process (e.g. if a function with a critical section is called from another
- *  critical section) to ensure correct behaviour when leaving the section.
- *  This function supports up to 255 nested critical sections.
+ *  Error path of os_enterCriticalSection and os_leaveCriticalSection, out
+ *  of line so the inline fast paths stay small.
+ *
+ *  \param overflow True if more than 255 sections were nested, false if a
+ *                  section was left that was not entered.
  */
-void os_enterCriticalSection(void) {
-	
-	uint8_t gie = SREG & 0b10000000;
-	cli();
-	if (criticalSectionCount == UINT8_MAX) {
-		SREG |= gie;
+void os_criticalSectionFault(bool overflow) {
+	if (overflow) {
 		os_errorPStr(PSTR("CritSec overflow"));
-		return;
-	}
-	if (criticalSectionCount++ == 0) {
-		TIMSK2 &= 0b111111101;
-	}
-	SREG |= gie;
-	
-//#warning IMPLEMENT STH. HERE
-}
-
-/*!
- *  Leaves a critical code section by enabling the scheduler if needed.
- *  This function utilizes the nesting depth of critical sections
- *  stored by os_enterCriticalSection to check if the scheduler
- *  has to be reactivated.
- */
-void os_leaveCriticalSection(void){
-	
-	uint8_t gie = SREG & 0b10000000;
-	cli();
-	if (criticalSectionCount == 0) {
-		SREG |= gie;
+	} else {
 		os_errorPStr(PSTR("CritSec underflow"));
-		return;
-	}
-	if (--criticalSectionCount == 0) {
-		TIMSK2 |= 0b00000010;
 	}
-	SREG |= gie;
-
-
-//#warning IMPLEMENT STH. HERE
 }
 
 /*!
@@ -425,14 +453,27 @@ bool os_kill(ProcessID pid){
 		 os_leaveCriticalSection();
 		 return false;
 	 }
+	 // der offene Taskmanager kann sich nicht selbst beenden
+	 if(pid == taskManProc){
+		 os_leaveCriticalSection();
+		 return false;
+	 }
+	 // der Stream des Prozesses: Empfnger samt Interrupt aus, Puffer zurck in den Heap
+	 if(stream_getProcess() == pid){
+		 stream_stop();
+	 }
+	 // ein SPI-Auftrag des Prozesses liegt auf seinem Stack, der Slot wird erst danach frei
+	 os_spi_drain();
 	 os_processes[pid].state = OS_PS_UNUSED;
+	 os_trace(OS_TRACE_KILL, pid);
 	 if(pid == os_getCurrentProc()){
 		 while (criticalSectionCount != 1){
 			 os_leaveCriticalSection();
 		 }
 	 }
-	 os_freeProcessMemory(intHeap, pid);
-	 os_freeProcessMemory(extHeap, pid);
+	 for (uint8_t i = 0; i < os_getHeapListLength(); i++) {
+		 os_freeProcessMemory(os_lookupHeap(i), pid);
+	 }
 	 os_leaveCriticalSection();
 	 /*while (currentProc == pid){
 	 } */
@@ -450,6 +491,7 @@ bool os_kill(ProcessID pid){
 void os_yield(void){
 	
 	 os_enterCriticalSection();
+	 os_trace(OS_TRACE_YIELD, 0);
 
 	 // aktuelle prozess blocken
 	 uint8_t current = os_getCurrentProc();
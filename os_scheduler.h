@@ -11,7 +11,10 @@
 
 #include "defines.h"
 #include "os_process.h"
+#include "os_trace.h"
 
+#include <avr/interrupt.h>
+#include <avr/io.h>
 #include <stdbool.h>
 
 //----------------------------------------------------------------------------
@@ -60,11 +63,48 @@ StackChecksum os_getStackChecksum(ProcessID pid);
 // Critical section management
 //----------------------------------------------------------------------------
 
-//! Enters a critical code section
-void os_enterCriticalSection(void);
+//! Nesting depth of critical sections, only changed with interrupts disabled
+extern uint8_t criticalSectionCount;
 
-//! Leaves a critical code section
-void os_leaveCriticalSection(void);
+//! Reports a critical section that is nested too deep (overflow) or left too often
+void os_criticalSectionFault(bool overflow);
+
+/*!
+ *  Enters a critical code section by disabling the scheduler if needed.
+ *  Up to 255 sections can be nested. Inline, as drivers enter one per
+ *  transaction: a nested call only changes the counter (about 10 cycles),
+ *  the outermost one also masks the scheduler interrupt.
+ */
+static inline void os_enterCriticalSection(void) {
+    const uint8_t sreg = SREG;
+    cli();
+    if (criticalSectionCount == UINT8_MAX) {
+        SREG = sreg;
+        os_criticalSectionFault(true);
+        return;
+    }
+    if (criticalSectionCount++ == 0) {
+        TIMSK2 &= ~(1 << OCIE2A);
+        os_trace(OS_TRACE_CRIT_ENTER, 0);
+    }
+    SREG = sreg;
+}
+
+//! Leaves a critical code section, the scheduler is enabled again by the outermost one
+static inline void os_leaveCriticalSection(void) {
+    const uint8_t sreg = SREG;
+    cli();
+    if (criticalSectionCount == 0) {
+        SREG = sreg;
+        os_criticalSectionFault(false);
+        return;
+    }
+    if (--criticalSectionCount == 0) {
+        os_trace(OS_TRACE_CRIT_LEAVE, 0);
+        TIMSK2 |= (1 << OCIE2A);
+    }
+    SREG = sreg;
+}
 
 
 
@@ -7,6 +7,9 @@
 #include "os_spi.h"
 #include "os_scheduler.h"
 
+#include <stddef.h>
+#include <util/atomic.h>
+
 
 /* MOSI, SCK, CS als ausgang, MISO als eingang , 
 CS auf high,SPE fr SPI enable, 
@@ -14,8 +17,15 @@ MSTR master mode, CPOL=0 und CPHA=0 f
 DORD=0 fr MSB first ,SPI2X=1, SPR1 und SPR0 =0 fr fcpu/2  */
 
 
+// Warteschlange der Auftraege, queueHead wird gerade uebertragen
+static SpiTransfer *volatile queueHead = NULL;
+static SpiTransfer *queueTail = NULL;
+// Ein Prozess benutzt den Bus direkt (os_spi_select)
+static volatile bool polled = false;
+
+
 void os_spi_init(void) {
-	// pins belegung
+	// pins belegung, CS (SS) muss Ausgang bleiben, sonst wird der SPI zum Slave
 	SPI_DDR  |=  (1<<SPI_CS) | (1<<SPI_MOSI) | (1<<SPI_SCK); // Ausgang
 	SPI_DDR  &= ~(1<<SPI_MISO);                              // Eingang
 	SPI_PORT |=  (1<<SPI_MISO);
@@ -28,16 +38,138 @@ void os_spi_init(void) {
 	SPSR = (1<<SPI2X);   // fcpu/2
 }
 
-uint8_t os_spi_send(uint8_t data) {
-	uint8_t result;
-	os_enterCriticalSection();
-	SPDR = data;        // start transmission
-	while (!(SPSR & (1<<SPIF))); // wait for completion
-	result = SPDR;      // read received byte
-	os_leaveCriticalSection();
-	return result;
+void os_spi_initDevice(SpiDevice const *device) {
+	ATOMIC {
+		*device->csPort |= device->csMask;
+		*(device->csPort - 1) |= device->csMask;    // DDRx
+	}
+}
+
+// Modus des Geraets einstellen, SPIE nur fuer die Warteschlange
+static void spi_configure(SpiDevice const *device, bool interrupt) {
+	SPCR = (1<<SPE) | (1<<MSTR) | (interrupt ? (1<<SPIE) : 0) | device->spcr;
+	SPSR = device->spsr;
+}
+
+static uint8_t spi_nextByte(SpiTransfer const *transfer, uint16_t position) {
+	if (position < transfer->headerLength) {
+		return transfer->header[position];
+	}
+	return transfer->tx ? transfer->tx[position - transfer->headerLength] : transfer->fill;
+}
+
+// Beginnt den ersten Auftrag der Warteschlange, mit gesperrten Interrupts
+static void spi_startNext(void) {
+	if (polled) {
+		return;     // os_spi_deselect macht weiter
+	}
+	if (!queueHead) {
+		SPCR &= ~(1<<SPIE);
+		return;
+	}
+	spi_configure(queueHead->device, true);
+	*queueHead->device->csPort &= ~queueHead->device->csMask;
+	SPDR = spi_nextByte(queueHead, 0);
+}
+
+/* Ein Byte ist fertig: Antwort speichern, naechstes senden. Am Ende des
+   Auftrags Chip Select loesen, Callback aufrufen, naechsten beginnen. */
+ISR(SPI_STC_vect) {
+	SpiTransfer *transfer = queueHead;
+	uint8_t data = SPDR;
+	uint16_t position = transfer->position;
+	if (position >= transfer->headerLength && transfer->rx) {
+		transfer->rx[position - transfer->headerLength] = data;
+	}
+	transfer->position = ++position;
+	if (position < transfer->headerLength + transfer->length) {
+		SPDR = spi_nextByte(transfer, position);
+		return;
+	}
+	*transfer->device->csPort |= transfer->device->csMask;
+	queueHead = transfer->next;
+	if (!queueHead) {
+		queueTail = NULL;
+	}
+	transfer->done = true;
+	if (transfer->callback) {
+		transfer->callback(transfer);
+	}
+	spi_startNext();
+}
+
+void os_spi_submit(SpiTransfer *transfer) {
+	transfer->position = 0;
+	transfer->next = NULL;
+	if (transfer->headerLength + transfer->length == 0) {
+		transfer->done = true;
+		if (transfer->callback) {
+			transfer->callback(transfer);
+		}
+		return;
+	}
+	transfer->done = false;
+	ATOMIC {
+		if (queueTail) {
+			queueTail->next = transfer;
+			queueTail = transfer;
+		} else {
+			queueHead = queueTail = transfer;
+			spi_startNext();
+		}
+	}
+}
+
+bool os_spi_canYield(void) {
+	return !criticalSectionCount && (SREG & (1 << 7));
+}
+
+void os_spi_wait(SpiTransfer const *transfer) {
+	while (!transfer->done) {
+		// sonst aktiv warten, der ISR arbeitet weiter
+		if (os_spi_canYield()) {
+			os_yield();
+		}
+	}
+}
+
+void os_spi_transfer(SpiTransfer *transfer) {
+	os_spi_submit(transfer);
+	os_spi_wait(transfer);
+}
+
+void os_spi_waitIdle(void) {
+	while (os_spi_isBusy() && os_spi_canYield()) {
+		os_yield();
+	}
 }
 
-uint8_t os_spi_receive(void) {
-	return os_spi_send(0xFF);
-}
\ No newline at end of file
+void os_spi_drain(void) {
+	while (queueHead);
+}
+
+void os_spi_select(SpiDevice const *device) {
+	while (1) {
+		ATOMIC {
+			if (!queueHead) {
+				polled = true;
+				spi_configure(device, false);
+				*device->csPort &= ~device->csMask;
+				return;
+			}
+		}
+	}
+}
+
+void os_spi_deselect(SpiDevice const *device) {
+	ATOMIC {
+		*device->csPort |= device->csMask;
+		polled = false;
+		// waehrenddessen von einem ISR eingereiht
+		spi_startNext();
+	}
+}
+
+bool os_spi_isBusy(void) {
+	return polled || queueHead;
+}
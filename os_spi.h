@@ -3,10 +3,11 @@
  *
  * Created: 13.06.2025 18:31:16
  *  Author: yousef
- */ 
+ */
 #include "util.h"
 #include <avr/interrupt.h>
 #include <avr/io.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 
@@ -14,20 +15,98 @@
 #define OS_SPI_H_
 
 
+/* Geraet am SPI-Bus. spcr enthaelt nur CPOL, CPHA, DORD, SPR1 und SPR0
+   (SPE, MSTR und SPIE setzt der Treiber), spsr nur SPI2X. Der Modus wird
+   bei jeder Transaktion neu eingestellt, Geraete mit verschiedenen Modi
+   und Teilern koennen sich also den Bus teilen. Chip Select nicht auf
+   PORTB ausser PB4: das LCD schreibt den ganzen Port. */
+typedef struct SpiDevice {
+	volatile uint8_t *csPort;   // z.B. &PORTB, DDRx liegt direkt davor
+	uint8_t csMask;             // (1 << Pin)
+	uint8_t spcr;
+	uint8_t spsr;
+} SpiDevice;
+
+struct SpiTransfer;
+
+// Wird im ISR aufgerufen, wenn der Auftrag fertig ist
+typedef void SpiCallback(struct SpiTransfer *transfer);
+
+/* Auftrag fuer die Warteschlange, alles mit einem Chip Select: erst header
+   (Befehl, Adresse, die Antwort wird verworfen), dann length Bytes aus tx
+   (NULL: fill senden) nach rx (NULL: verwerfen). Der Auftrag und die Puffer
+   gehoeren dem Treiber, bis done gesetzt ist. */
+typedef struct SpiTransfer {
+	SpiDevice const *device;
+	uint8_t const *header;
+	uint8_t headerLength;
+	uint8_t const *tx;
+	uint8_t *rx;
+	uint8_t fill;
+	uint16_t length;
+	SpiCallback *callback;      // darf NULL sein
+	volatile bool done;
+	// intern
+	uint16_t position;
+	struct SpiTransfer *next;
+} SpiTransfer;
+
+
 void os_spi_init(void);
 
+// Chip Select als Ausgang und inaktiv
+void os_spi_initDevice(SpiDevice const *device);
+
+// Haengt den Auftrag an die Warteschlange und kehrt sofort zurueck
+void os_spi_submit(SpiTransfer *transfer);
+
+/* Ob der laufende Prozess warten und dabei die CPU abgeben kann: nicht in
+   einer kritischen Sektion, nicht mit gesperrten Interrupts (ISR, Boot). */
+bool os_spi_canYield(void);
+
+// Wartet auf das Ende, laesst solange andere Prozesse laufen, wenn os_spi_canYield
+void os_spi_wait(SpiTransfer const *transfer);
+
+// os_spi_submit und os_spi_wait
+void os_spi_transfer(SpiTransfer *transfer);
+
+// Gibt die CPU ab, bis die Warteschlange leer ist (nur wenn os_spi_canYield)
+void os_spi_waitIdle(void);
+
+/* Wartet aktiv, bis die Warteschlange leer ist. Fuer os_kill: Auftraege
+   liegen auf dem Stack ihres Prozesses. Nur mit freigegebenen Interrupts. */
+void os_spi_drain(void);
+
+/* Direkter Zugriff ohne Interrupts fuer kurze Transaktionen (wenige Bytes
+   bei fcpu/2 sind schneller als ein ISR pro Byte): wartet, bis die
+   Warteschlange leer ist, stellt den Modus ein und waehlt das Geraet aus.
+   Nur in einer kritischen Sektion, bis os_spi_deselect. */
+void os_spi_select(SpiDevice const *device);
+
+void os_spi_deselect(SpiDevice const *device);
+
+// true waehrend einer Transaktion, das LCD wartet solange mit PORTB
+bool os_spi_isBusy(void);
+
 
-uint8_t os_spi_send(uint8_t data);
+/* Ein Byte uebertragen, nur zwischen os_spi_select und os_spi_deselect. */
+static inline uint8_t os_spi_send(uint8_t data) {
+	SPDR = data;                    // start transmission
+	while (!(SPSR & (1<<SPIF)));    // wait for completion
+	return SPDR;                    // read received byte
+}
 
 
-uint8_t os_spi_receive();
+static inline uint8_t os_spi_receive(void) {
+	return os_spi_send(0xFF);
+}
 
 
 #define SPI_DDR   DDRB
 #define SPI_PORT  PORTB
-#define SPI_CS    PB4    
+#define SPI_CS    PB4
 #define SPI_MOSI  PB5
 #define SPI_MISO  PB6
 #define SPI_SCK   PB7
 
-#endif /* OS_SPI_H_ */
\ No newline at end of file
+#endif /* OS_SPI_H_ */
@@ -38,8 +38,10 @@
 #include "os_input.h"
 #include "os_process.h"
 #include "os_scheduler.h"
+#include "os_trace.h"
 #include "os_user_privileges.h"
 #if (VERSUCH >= 3)
+#include "led_heapmap.h"
 #include "os_memory.h"
 #endif
 
@@ -286,7 +288,7 @@ void os_taskManMain(void) {
                 lcd_writeString(reason16);
             }
             // Wait for confirmation (OK+ES)
-            while (os_getInput() != (1 | (1 << 3))) continue;
+            while (os_getInput() != (1 | (1 << 3))) os_yield();
             os_waitForNoInput();
             return;
 
@@ -355,6 +357,8 @@ void os_taskManMain(void) {
         do {
             stack.pages[stack.top].param += direction;
             stack.pages[stack.top].param %= stack.pages[stack.top].range;
+            // Only the cells that differ from the previous page are sent
+            lcd_beginFrame();
             lcd_clear();
 
             /*
@@ -363,6 +367,7 @@ void os_taskManMain(void) {
              * not execute a command by the user.
              */
             stack.pages[stack.top].call(&stack, &pageResult);
+            lcd_present();
 
             /*
              * If the user did not actually want to move (e.g. he just entered this
@@ -388,7 +393,7 @@ void os_taskManMain(void) {
                  * process it, we will still know it was pressed (updateInput() has
                  * heavy side effects, as it is a macro).
                  */
-                while (!updateInput()) continue;
+                while (!updateInput()) os_yield();
             }
             newInput = true;
             if (READ_BTN(ES) || !pageResult.success) {
@@ -417,7 +422,7 @@ void os_taskManMain(void) {
                  */
                 newInput = false;
             }
-            while (updateInput()) continue;
+            while (updateInput()) os_yield();
         } while (!newInput);
         // This can occur if our design-time estimate of the stack size was too small.
         // { stack.top + 1 != 0 }
@@ -435,7 +440,8 @@ char PROGMEM const mainLabels[] =
     "Kill Process                   \0"
     "Change Priority                \0"
     "Change Scheduling Strategy     \0"
-    "Heap(s)                        \0";
+    "Heap(s)                        \0"
+    "Send trace over USART          \0";
 
 // Forward declarations for the sub-pages of the root-page.
 static tm_page tm_frontpage;
@@ -456,6 +462,10 @@ static tm_page tm_scheduling;
 static tm_page tm_heap;
 #endif
 
+#if OS_TRACE_ENABLED
+static tm_page tm_trace;
+#endif
+
 static tm_page tm_null;
 
 // A convenience macro to access the stack-history.
@@ -513,6 +523,9 @@ static TM_PAGE(tm_rootpage) {
 #if TM_COMPILE_HEAP_SUPPORT
         SUBP(4, tm_heap, 0, TM_HEAP_SUPPORT)
 #endif
+#if OS_TRACE_ENABLED
+        SUBP(5, tm_trace, 0, 1)
+#endif
 #undef SUBP
         default:
             result->child.call = tm_null;
@@ -635,6 +648,29 @@ MAKE_PAGEHANDLER(tm_frontpage, tm_null, 0, 0, OS_PR_FRONTPAGE, null, 0) {
     return true;
 }
 
+#if OS_TRACE_ENABLED
+/*!
+ * The page to confirm sending the scheduler trace (see os_trace.h).
+ */
+MAKE_PAGEHANDLER(tm_trace, tm_trace_send, 0, 0, OS_PR_ALWAYS_ALLOW, null, 0) {
+    lcd_writeProgString(PSTR("Send "));
+    lcd_writeDec(os_traceCount());
+    lcd_writeProgString(PSTR(" events?"));
+    return true;
+}
+
+/*!
+ * The page that sends the trace. The TM itself is recorded as well, so the
+ * trace ends with the switches to the TM.
+ */
+MAKE_PAGEHANDLER(tm_trace_send, tm_null, 0, 0, OS_PR_ALWAYS_ALLOW, null, 0) {
+    lcd_writeProgString(PSTR("Sending trace"));
+    os_traceDump();
+    tm_done();
+    return true;
+}
+#endif
+
 // XXX slightly ugly
 #define uniqState(state) (((uint32_t)1) << (state))
 
@@ -970,21 +1006,22 @@ MAKE_PAGEHANDLER(tm_scheduling_set, tm_null, 0, 0, OS_PR_SCHEDULING, ss, peekSta
 
 #if TM_COMPILE_HEAP_SUPPORT
 
+//! The name is in the flash
 static const char *getHeapName(uint8_t ram) {
     Heap *const heap = os_lookupHeap(ram);
-    return heap ? (heap->name) : "unnamed";
+    return heap ? (heap->name) : PSTR("unnamed");
 }
 
 /*!
  * The page to select which heap to inspect. Supports NULL-heaps.
  */
-MAKE_PAGEHANDLER(tm_heap, tm_heap2, 0, 4, OS_PR_SHOW_HEAP, heapId, peekStack(0).param) {
+MAKE_PAGEHANDLER(tm_heap, tm_heap2, 0, 6, OS_PR_SHOW_HEAP, heapId, peekStack(0).param) {
     const uint16_t ram = peekStack(0).param;
     if (ram >= os_getHeapListLength() || !os_lookupHeap(ram)) {
         return false;
     }
     lcd_writeProgString(PSTR("Open "));
-    lcd_writeString(getHeapName(ram));
+    lcd_writeProgString(getHeapName(ram));
     lcd_writeProgString(PSTR(" Heap"));
     return true;
 }
@@ -994,6 +1031,8 @@ static tm_page tm_heap_strategy;
 static tm_page tm_heap_contents;
 static tm_page tm_heap_chunks;
 static tm_page tm_heap_erase;
+static tm_page tm_heap_panel;
+static tm_page tm_heap_stats;
 
 /*!
  * The page to select what to do with a previously selected heap.
@@ -1002,6 +1041,8 @@ static tm_page tm_heap_erase;
  *  - dump the map
  *  - browse chunks
  *  - erase everything
+ *  - show the map on the LED panel
+ *  - show the statistics
  */
 MAKE_PAGEHANDLER(tm_heap2, tm_heap_strategy, 0, MS_MAX_COUNT, OS_PR_ALWAYS_ALLOW, null, 0) {
     Heap *const heap = os_lookupHeap(peekStack(1).param);
@@ -1032,6 +1073,20 @@ MAKE_PAGEHANDLER(tm_heap2, tm_heap_strategy, 0, MS_MAX_COUNT, OS_PR_ALWAYS_ALLOW
             result->range = 1;
             break;
         }
+        case 4: {
+            lcd_writeProgString(PSTR("Panel heat map"));
+            result->call = tm_heap_panel;
+            result->param = 0;
+            result->range = 1;
+            break;
+        }
+        case 5: {
+            lcd_writeProgString(PSTR("Statistics"));
+            result->call = tm_heap_stats;
+            result->param = 0;
+            result->range = 3;
+            break;
+        }
         default:
             return false;
     }
@@ -1120,31 +1175,69 @@ MAKE_PAGEHANDLER(tm_heap_chunks, tm_null, 0, 0, OS_PR_SHOW_HEAP, null, 0) {
 
 MAKE_PAGEHANDLER(tm_heap_erase, tm_heap_erase2, 0, 1, OS_PR_ERASE_HEAP, heapId, peekStack(2).param) {
     lcd_writeProgString(PSTR("Erase map+dat of"));
-    lcd_writeString(getHeapName(peekStack(2).param));
+    lcd_writeProgString(getHeapName(peekStack(2).param));
     lcd_writeChar('?');
     return true;
 }
 
 MAKE_PAGEHANDLER(tm_heap_erase2, tm_null, 0, 0, OS_PR_ERASE_HEAP, heapId, peekStack(3).param) {
     lcd_writeProgString(PSTR("Erasing "));
-    lcd_writeString(getHeapName(peekStack(3).param));
+    lcd_writeProgString(getHeapName(peekStack(3).param));
     lcd_writeProgString(PSTR("..."));
-    Heap *const heap = os_lookupHeap(peekStack(3).param);
-    MemAddr start = os_getMapStart(heap);
-    MemAddr end = os_getMapStart(heap) + os_getMapSize(heap);
-    const MemAddr mapEnd = end;
-    MemAddr ptr;
-    uint8_t lastProgress = 0;
-    for (ptr = start; ptr < end; ptr++) {
-        heap->driver->write(ptr, 0);
-        uint8_t progress = (100ul * (uint16_t)(ptr - start)) / (uint16_t)(end - start);
-        if (((uint16_t)progress * 32ul) / 100ul != ((uint16_t)lastProgress * 32ul) / 100ul) {
-            lcd_drawBar((lastProgress = progress));
-        }
-        if (ptr + 1 == mapEnd) {
-            ptr = (start = os_getUseStart(heap)) - 1;
-            end = os_getUseStart(heap) + os_getUseSize(heap);
-        }
+    // Other processes keep running, the heap is erased in one critical section
+    os_eraseHeap(os_lookupHeap(peekStack(3).param));
+    tm_done();
+    return true;
+}
+
+/*!
+ * The pages with the statistics of the previously selected heap: the
+ * bytes in use, the chunks and the largest free block, the allocations
+ * that failed.
+ */
+MAKE_PAGEHANDLER(tm_heap_stats, tm_null, 0, 0, OS_PR_SHOW_HEAP, null, 0) {
+    Heap *const heap = os_lookupHeap(peekStack(2).param);
+    HeapStats stats;
+    os_getHeapStats(heap, &stats);
+    switch (peekStack(0).param) {
+        case 0:
+            lcd_writeProgString(PSTR("Used "));
+            lcd_writeDec(stats.used);
+            lcd_writeChar('/');
+            lcd_writeDec(os_getUseSize(heap));
+            lcd_line2();
+            lcd_writeProgString(PSTR("Peak "));
+            lcd_writeDec(stats.peakUsed);
+            break;
+        case 1:
+            lcd_writeProgString(PSTR("Chunks "));
+            lcd_writeDec(stats.chunks);
+            lcd_line2();
+            lcd_writeProgString(PSTR("Free block "));
+            lcd_writeDec(stats.largestFree);
+            break;
+        default:
+            lcd_writeProgString(PSTR("Failed allocs"));
+            lcd_line2();
+            lcd_writeDec(stats.failures);
+            break;
+    }
+    return true;
+}
+
+/*!
+ * The page to switch the allocation map of the previously selected heap on
+ * the LED panel on or off. It stays on after the TM is left.
+ */
+MAKE_PAGEHANDLER(tm_heap_panel, tm_null, 0, 0, OS_PR_SHOW_HEAP, heapId, peekStack(2).param) {
+    Heap *const heap = os_lookupHeap(peekStack(2).param);
+    lcd_writeProgString(getHeapName(peekStack(2).param));
+    if (heapmap_getHeap() == heap) {
+        lcd_writeProgString(PSTR(" map off"));
+        heapmap_hide();
+    } else {
+        lcd_writeProgString(PSTR(" map on"));
+        heapmap_show(heap);
     }
     tm_done();
     return true;
@@ -0,0 +1,161 @@
+/*! \file
+ *  \brief Trace of scheduler and heap events
+ *
+ *  Events are recorded with interrupts disabled, so the scheduler ISR and
+ *  processes can record at any time. The buffer is not recorded into while
+ *  it is sent.
+ */
+
+#include "os_trace.h"
+
+#include "atmega644constants.h"
+#include "os_scheduler.h"
+#include "util.h"
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include <util/atomic.h>
+
+#if (OS_TRACE_SIZE & (OS_TRACE_SIZE - 1)) || OS_TRACE_SIZE > 128
+#error "OS_TRACE_SIZE must be a power of two up to 128"
+#endif
+
+#if OS_TRACE_ENABLED
+
+static OsTraceEvent events[OS_TRACE_SIZE];
+//! Index of the next event and number of events in the buffer
+static uint8_t next = 0;
+static uint8_t count = 0;
+//! Events that were overwritten since the last dump
+static uint16_t lost = 0;
+static volatile bool sending = false;
+//! High word of the time in the last OS_TRACE_TIME record, invalid after a dump
+static uint16_t anchor;
+static bool anchored = false;
+
+//! Appends a record, must be called with interrupts disabled
+static void os_tracePut(uint16_t time, OsTraceType type, uint16_t arg) {
+    OsTraceEvent *event = &events[next];
+    event->time = time;
+    event->type = type;
+    event->pid = os_getCurrentProc();
+    event->arg = arg;
+    next = (next + 1) & (OS_TRACE_SIZE - 1);
+    if (count < OS_TRACE_SIZE) {
+        count++;
+    } else {
+        lost++;
+    }
+}
+
+/*!
+ *  Records an OS_TRACE_TIME anchor first if the high word of the time has
+ *  changed, which happens at most every 0.84 s.
+ *
+ *  \param type The kind of event.
+ *  \param arg  Its argument, see OsTraceType.
+ */
+void os_traceRecord(OsTraceType type, uint16_t arg) {
+    if (sending) {
+        return;
+    }
+    ATOMIC {
+        const Time now = os_systemTime_ticks();
+        if (!anchored || (uint16_t)(now >> 16) != anchor) {
+            anchor = now >> 16;
+            anchored = true;
+            os_tracePut(now, OS_TRACE_TIME, anchor);
+        }
+        os_tracePut(now, type, arg);
+    }
+}
+
+#endif
+
+//! Sends a byte when the transmitter is ready for it, TXC0 is only set after the last one
+static void os_traceSend(uint8_t data) {
+    while (!(UCSR0A & (1 << UDRE0))) {
+    }
+    UCSR0A |= (1 << TXC0);
+    UDR0 = data;
+}
+
+static void os_traceSendWord(uint16_t data) {
+    os_traceSend(data);
+    os_traceSend(data >> 8);
+}
+
+static void os_traceSendLong(uint32_t data) {
+    os_traceSendWord(data);
+    os_traceSendWord(data >> 16);
+}
+
+/*!
+ *  Sends the header and all events and empties the buffer. The receiver of
+ *  USART0 (panel streaming) is left as it is, both use the same baud rate.
+ *  Takes about 8 ms with a full buffer.
+ */
+void os_traceDump(void) {
+    uint8_t records = 0;
+    uint16_t overwritten = 0;
+    const Time now = os_systemTime_ticks();
+#if OS_TRACE_ENABLED
+    sending = true;
+    records = count;
+    overwritten = lost;
+#endif
+
+    // Changing the baud rate would disturb a byte the receiver is getting
+    if (!(UCSR0B & (1 << RXEN0))) {
+        UBRR0 = AVR_CLOCK_FREQUENCY / (8 * OS_TRACE_BAUD) - 1;
+        UCSR0A = (1 << U2X0);
+        UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+    }
+    UCSR0B |= (1 << TXEN0);
+
+    os_traceSend('S');
+    os_traceSend('P');
+    os_traceSend('T');
+    os_traceSend('1');
+    os_traceSend(sizeof(OsTraceEvent));
+    os_traceSend(records);
+    os_traceSendWord(overwritten);
+    os_traceSendLong(now);
+    os_traceSendLong(F_CPU / TC0_PRESCALER);
+
+#if OS_TRACE_ENABLED
+    uint8_t index = (next - count) & (OS_TRACE_SIZE - 1);
+    for (uint8_t i = 0; i < records; i++) {
+        const OsTraceEvent *event = &events[index];
+        os_traceSendWord(event->time);
+        os_traceSend(event->type);
+        os_traceSend(event->pid);
+        os_traceSendWord(event->arg);
+        index = (index + 1) & (OS_TRACE_SIZE - 1);
+    }
+#endif
+
+    // Let the last byte leave before PD1 is given back to the panel
+    while (!(UCSR0A & (1 << TXC0))) {
+    }
+    UCSR0B &= ~(1 << TXEN0);
+    DDRD |= (1 << PD1);
+
+#if OS_TRACE_ENABLED
+    ATOMIC {
+        count = 0;
+        lost = 0;
+        anchored = false;
+    }
+    sending = false;
+#endif
+}
+
+//! \return Number of events in the buffer
+uint8_t os_traceCount(void) {
+#if OS_TRACE_ENABLED
+    return count;
+#else
+    return 0;
+#endif
+}
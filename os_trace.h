@@ -0,0 +1,96 @@
+/*! \file
+ *  \brief Trace of scheduler and heap events
+ *
+ *  The scheduler and the heap record what they do into a ring buffer in
+ *  SRAM, the newest OS_TRACE_SIZE events are kept. Recording is enabled at
+ *  compile time with OS_TRACE_ENABLED, otherwise os_trace compiles to
+ *  nothing. An event costs about 60 cycles.
+ *
+ *  os_traceDump sends the buffer over USART0 (8N1, OS_TRACE_BAUD), all
+ *  values little endian:
+ *    header: 'S' 'P' 'T' '1'
+ *            record size (1 byte, 6)
+ *            number of records (1 byte)
+ *            number of events that were overwritten (2 bytes)
+ *            system time at the dump in timer 0 ticks (4 bytes)
+ *            timer 0 ticks per second (4 bytes)
+ *    then the records, oldest first:
+ *            time   low 16 bits of the system time in ticks (wraps every 0.84 s)
+ *            type   OsTraceType
+ *            pid    process that was running
+ *            arg    depends on the type, see OsTraceType
+ *  Before the first event after a dump and before every event whose high
+ *  16 bits of the time differ from the previous one, an OS_TRACE_TIME record
+ *  carries the high word, so the full time of a record is the arg of the
+ *  last OS_TRACE_TIME before it and its own time, however long the gaps
+ *  between events are. Records older than the oldest OS_TRACE_TIME left in
+ *  the buffer (it may have been overwritten) are unwrapped backwards from
+ *  it. A host tool turns OS_TRACE_SWITCH
+ *  records into one slice per process and the others into instant events
+ *  of a Chrome trace / Perfetto timeline.
+ *
+ *  Note that TXD0 is PD1, which is also the G1 data line of the panel. The
+ *  upper half shows wrong green values while a dump is sent.
+ */
+#ifndef _OS_TRACE_H
+#define _OS_TRACE_H
+#include <stdint.h>
+
+//! Set to 1 to record events (costs 6 * OS_TRACE_SIZE bytes of SRAM)
+#ifndef OS_TRACE_ENABLED
+#define OS_TRACE_ENABLED 0
+#endif
+
+//! Number of events that are kept, a power of two up to 128
+#define OS_TRACE_SIZE 64
+
+//! Baud rate of the dump (exact at 20 MHz with double speed)
+#define OS_TRACE_BAUD 500000ul
+
+//! Kinds of events, the comments give the meaning of arg
+typedef enum {
+    //! The scheduler handed the CPU to pid (arg: the pid that ran before)
+    OS_TRACE_SWITCH = 1,
+    //! A process was started (arg: new pid | priority << 8)
+    OS_TRACE_EXEC,
+    //! A process was killed (arg: its pid)
+    OS_TRACE_KILL,
+    //! The running process blocks itself until the next round (os_yield)
+    OS_TRACE_YIELD,
+    //! Outermost critical section entered or left
+    OS_TRACE_CRIT_ENTER,
+    OS_TRACE_CRIT_LEAVE,
+    //! Heap operations (arg: size in bytes)
+    OS_TRACE_MALLOC,
+    OS_TRACE_FREE,
+    //! Time anchor, recorded before the event it belongs to (arg: high 16 bits of the system time)
+    OS_TRACE_TIME
+} OsTraceType;
+
+typedef struct {
+    uint16_t time;
+    uint8_t type;
+    uint8_t pid;
+    uint16_t arg;
+} OsTraceEvent;
+
+#if OS_TRACE_ENABLED
+
+//! Records an event of the running process
+void os_traceRecord(OsTraceType type, uint16_t arg);
+
+#define os_trace(type, arg) os_traceRecord((type), (arg))
+
+#else
+
+#define os_trace(type, arg) ((void)0)
+
+#endif
+
+//! Sends all recorded events over USART0 and starts a new recording
+void os_traceDump(void);
+
+//! Number of recorded events in the buffer
+uint8_t os_traceCount(void);
+
+#endif
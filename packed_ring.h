@@ -0,0 +1,113 @@
+/*! \file
+ *  \brief Ring buffer of 2 bit entries
+ *
+ *  Four entries share a byte, entry i is in bits 2 * (i % 4) of byte i / 4.
+ *  This is the natural format for paths on a grid (one direction per step),
+ *  used by the body of the snake and available to anything else that records
+ *  paths. Access to an entry is a shift and a mask, there is no branch on
+ *  the position within the byte.
+ *
+ *  The storage is provided by the user. Static storage is declared with
+ *  PACKED_RING_STORAGE, which checks the capacity at compile time; storage
+ *  from a heap is sized with PACKED_RING_BYTES.
+ *
+ *  All functions are inline, they are used once per step of a game.
+ */
+#ifndef _PACKED_RING_H
+#define _PACKED_RING_H
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Largest capacity, the indices are 16 bit
+#define PACKED_RING_MAX_CAPACITY 0xFFFC
+
+//! Bytes needed for capacity entries
+#define PACKED_RING_BYTES(capacity) (((capacity) + 3) / 4)
+
+//! Declares storage for capacity entries, the capacity is checked at compile time
+#define PACKED_RING_STORAGE(name, capacity)                                                          \
+    _Static_assert((capacity) > 0 && (capacity) <= PACKED_RING_MAX_CAPACITY, "Invalid ring capacity"); \
+    uint8_t name[PACKED_RING_BYTES(capacity)]
+
+typedef struct {
+    uint8_t *data;
+    //! Number of entries the storage holds (a multiple of 4)
+    uint16_t capacity;
+    //! Index of the next entry to be pushed and of the oldest entry
+    uint16_t head;
+    uint16_t tail;
+    uint16_t length;
+} PackedRing;
+
+/*!
+ *  \param ring  The ring to initialize (empty afterwards).
+ *  \param data  Storage of the entries.
+ *  \param bytes Size of the storage, at most PACKED_RING_BYTES(PACKED_RING_MAX_CAPACITY).
+ */
+static inline void packedRing_init(PackedRing *ring, uint8_t *data, uint16_t bytes) {
+    ring->data = data;
+    ring->capacity = bytes > PACKED_RING_BYTES(PACKED_RING_MAX_CAPACITY) ? PACKED_RING_MAX_CAPACITY : bytes * 4;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->length = 0;
+}
+
+//! Entry at an absolute index of the storage
+static inline uint8_t packedRing_read(const PackedRing *ring, uint16_t index) {
+    return (ring->data[index / 4] >> ((index % 4) * 2)) & 0x03;
+}
+
+static inline void packedRing_write(PackedRing *ring, uint16_t index, uint8_t value) {
+    const uint8_t shift = (index % 4) * 2;
+    uint8_t *byte = &ring->data[index / 4];
+    *byte = (*byte & ~(0x03 << shift)) | ((value & 0x03) << shift);
+}
+
+static inline uint16_t packedRing_next(const PackedRing *ring, uint16_t index) {
+    return ++index == ring->capacity ? 0 : index;
+}
+
+static inline bool packedRing_isFull(const PackedRing *ring) {
+    return ring->length == ring->capacity;
+}
+
+/*!
+ *  Appends an entry at the head.
+ *
+ *  \return False if the ring is full, nothing is changed then.
+ */
+static inline bool packedRing_pushHead(PackedRing *ring, uint8_t value) {
+    if (packedRing_isFull(ring)) {
+        return false;
+    }
+    packedRing_write(ring, ring->head, value);
+    ring->head = packedRing_next(ring, ring->head);
+    ring->length++;
+    return true;
+}
+
+/*!
+ *  Removes the oldest entry. The ring must not be empty.
+ *
+ *  \return The removed entry.
+ */
+static inline uint8_t packedRing_popTail(PackedRing *ring) {
+    const uint8_t value = packedRing_read(ring, ring->tail);
+    ring->tail = packedRing_next(ring, ring->tail);
+    ring->length--;
+    return value;
+}
+
+/*!
+ *  Iterates backward from the newest entry.
+ *
+ *  \param ring The ring to read.
+ *  \param age  0 for the newest entry, length - 1 for the oldest.
+ *  \return The entry.
+ */
+static inline uint8_t packedRing_fromHead(const PackedRing *ring, uint16_t age) {
+    const uint16_t index = ring->head > age ? ring->head - 1 - age : ring->head + ring->capacity - 1 - age;
+    return packedRing_read(ring, index);
+}
+
+#endif
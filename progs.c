@@ -11,6 +11,7 @@
 #include "joystick.h"
 #include "led_snake.h"
 #include "joystick.h"
+#include "led_stream.h"
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include <math.h>
@@ -32,6 +33,15 @@
 REGISTER_AUTOSTART(snake)
 void snake(void){
 	
+	// Joystick beim Start nach oben gedrueckt: das Panel zeigt, was ein Host ueber USART0 schickt
+	js_init();
+	if (js_getDirection() == JS_UP){
+		panel_init();
+		panel_initTimer();
+		panel_startTimer();
+		stream_main();
+		return;
+	}
 
 	play_Snake();
 	
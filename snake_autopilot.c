@@ -0,0 +1,137 @@
+/*! \file
+ *  \brief Computer player for the snake engine
+ *
+ *  The search needs no queue: one row of the grid is a 32 bit mask, and a
+ *  whole wave of the breadth first search is advanced at once by shifting
+ *  the masks of the current wave by one cell into every direction. The
+ *  search starts at the target, the first neighbour of the head that is
+ *  reached lies on a shortest path. Only the rows the wave has reached are
+ *  processed, so the cost of a wave is the height of the wave front and not
+ *  the size of the field. The wave is advanced in place and reached cells
+ *  are removed from the free cells, so all state fits into 256 bytes on the
+ *  stack of the calling process.
+ */
+
+#include "snake_autopilot.h"
+
+//! One bit per column of a row
+typedef uint32_t SnakeRow;
+
+//! Result of snake_wave if the target is not reachable
+#define SNAKE_UNREACHABLE SNAKE_KEEP
+
+//! Moves a cell one step into the given direction
+static SnakeCell snake_neighbour(SnakeCell cell, uint8_t direction) {
+    switch (direction) {
+        case SNAKE_UP: cell.y--; break;
+        case SNAKE_RIGHT: cell.x++; break;
+        case SNAKE_DOWN: cell.y++; break;
+        default: cell.x--; break;
+    }
+    return cell;
+}
+
+static bool snake_rowContains(const SnakeRow *rows, SnakeCell cell) {
+    return (rows[cell.y] >> cell.x) & 1;
+}
+
+//! Cells that are neither body nor wall, one mask per row
+static void snake_freeRows(const SnakeState *state, SnakeRow *free) {
+    const uint8_t *grid = state->occupancy;
+    for (uint8_t y = 0; y < SNAKE_ROWS; y++, grid += SNAKE_COLUMNS / 8) {
+        free[y] = ~((SnakeRow)grid[0] | (SnakeRow)grid[1] << 8 | (SnakeRow)grid[2] << 16 | (SnakeRow)grid[3] << 24);
+    }
+}
+
+/*!
+ *  Breadth first search from the target towards the head.
+ *
+ *  \param state  The game.
+ *  \param free   Free cells, the target has to be among them. The cells the
+ *                search reaches are removed.
+ *  \param target Cell to reach.
+ *  \return Direction of the first step of a shortest path, SNAKE_UNREACHABLE if there is none.
+ */
+static SnakeDir snake_wave(const SnakeState *state, SnakeRow *free, SnakeCell target) {
+    SnakeRow wave[SNAKE_ROWS] = {0};
+    uint8_t top = target.y;
+    uint8_t bottom = target.y;
+
+    wave[target.y] = (SnakeRow)1 << target.x;
+    free[target.y] &= ~wave[target.y];
+
+    for (uint16_t n = 0; n < SNAKE_AUTOPILOT_MAX_WAVES; n++) {
+        // Prefer to go on straight if several directions are equally good
+        for (uint8_t i = 0; i < 4; i++) {
+            const uint8_t direction = (state->direction + i) % 4;
+            if (snake_rowContains(wave, snake_neighbour(state->head, direction))) {
+                return direction;
+            }
+        }
+
+        // The walls are never free, so the wave can not leave the grid
+        const uint8_t from = top ? top - 1 : 0;
+        const uint8_t to = bottom < SNAKE_ROWS - 1 ? bottom + 1 : bottom;
+        bool reached = false;
+        // The old wave of the row above, that row is already overwritten (0 above the wave)
+        SnakeRow above = 0;
+        for (uint8_t y = from; y <= to; y++) {
+            SnakeRow spread = wave[y] | wave[y] << 1 | wave[y] >> 1 | above;
+            if (y < SNAKE_ROWS - 1) {
+                spread |= wave[y + 1];
+            }
+            above = wave[y];
+            wave[y] = spread & free[y];
+            if (wave[y]) {
+                free[y] &= ~wave[y];
+                if (!reached) {
+                    top = y;
+                    reached = true;
+                }
+                bottom = y;
+            }
+        }
+        if (!reached) {
+            return SNAKE_UNREACHABLE;
+        }
+    }
+    return SNAKE_UNREACHABLE;
+}
+
+/*!
+ *  Tries the food first. If there is no path to it, the tail is followed: the
+ *  tail moves away on the next step, so its cell is free to enter unless the
+ *  snake just ate. If neither works, any free neighbour is taken.
+ *
+ *  \param state The game to play.
+ *  \return Input for snake_step.
+ */
+SnakeDir snake_autopilot(const SnakeState *state) {
+    SnakeRow free[SNAKE_ROWS];
+    snake_freeRows(state, free);
+
+    if (state->food.x != SNAKE_NO_CELL) {
+        const SnakeDir direction = snake_wave(state, free, state->food);
+        if (direction != SNAKE_UNREACHABLE) {
+            return direction;
+        }
+        snake_freeRows(state, free);
+    }
+
+    if (!state->growing && state->length > 1) {
+        free[state->tail.y] |= (SnakeRow)1 << state->tail.x;
+        const SnakeDir direction = snake_wave(state, free, state->tail);
+        if (direction != SNAKE_UNREACHABLE) {
+            return direction;
+        }
+        snake_freeRows(state, free);
+    }
+
+    for (uint8_t i = 0; i < 4; i++) {
+        const uint8_t direction = (state->direction + i) % 4;
+        if (snake_rowContains(free, snake_neighbour(state->head, direction))) {
+            return direction;
+        }
+    }
+    return SNAKE_KEEP;
+}
@@ -0,0 +1,21 @@
+/*! \file
+ *  \brief Computer player for the snake engine
+ *
+ *  The autopilot searches the shortest path to the food with a breadth first
+ *  search over the occupancy grid of the game. If the food can not be
+ *  reached, it follows its own tail, which keeps the snake alive until the
+ *  body has moved out of the way.
+ *
+ *  Like the engine it only uses standard C, so it runs on a host as well.
+ */
+#ifndef _SNAKE_AUTOPILOT_H
+#define _SNAKE_AUTOPILOT_H
+#include "snake_engine.h"
+
+//! Maximum number of BFS waves per search, bounds the time of a step on the target
+#define SNAKE_AUTOPILOT_MAX_WAVES 256
+
+//! Chooses the input for the next step of a game
+SnakeDir snake_autopilot(const SnakeState *state);
+
+#endif
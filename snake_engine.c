@@ -0,0 +1,298 @@
+/*! \file
+ *  \brief Hardware independent game logic of snake
+ *
+ *  The body is kept in two structures that are both updated incrementally:
+ *  the occupancy grid answers "is this cell taken" in constant time, the
+ *  direction ring allows to move the tail without walking the body.
+ */
+
+#include "snake_engine.h"
+
+//! Width and height of the free area inside the walls
+#define SNAKE_FREE_COLUMNS(field) ((field)->columns - 2)
+#define SNAKE_FREE_ROWS(field) ((field)->rows - (field)->wallTop - 2)
+
+//! Result of snake_findFreeCell if the field is full
+#define SNAKE_NO_FREE_CELL 0xFFFF
+
+_Static_assert(SNAKE_COLUMNS * SNAKE_ROWS <= PACKED_RING_MAX_CAPACITY, "The body of a snake filling the field does not fit into a ring");
+
+static inline uint16_t snake_cellIndex(uint8_t x, uint8_t y) {
+    return (uint16_t)y * SNAKE_COLUMNS + x;
+}
+
+static void snake_mark(SnakeState *state, SnakeCell cell, bool occupied) {
+    const uint16_t index = snake_cellIndex(cell.x, cell.y);
+    if (occupied) {
+        state->occupancy[index / 8] |= (1 << (index % 8));
+    } else {
+        state->occupancy[index / 8] &= ~(1 << (index % 8));
+    }
+}
+
+//! Moves a cell one step into the given direction
+static SnakeCell snake_move(SnakeCell cell, uint8_t direction) {
+    switch (direction) {
+        case SNAKE_UP: cell.y--; break;
+        case SNAKE_RIGHT: cell.x++; break;
+        case SNAKE_DOWN: cell.y++; break;
+        default: cell.x--; break;
+    }
+    return cell;
+}
+
+/*!
+ *  Searches the next free cell from start on (wrapping around at the end of
+ *  the grid). Fully occupied bytes are skipped, so at most one pass over the
+ *  128 bytes of the grid is needed.
+ */
+static uint16_t snake_findFreeCell(const SnakeState *state, uint16_t start) {
+    uint8_t byteIndex = start / 8;
+    uint8_t mask = 0xFF << (start % 8);
+
+    // One byte more than the grid has, so the bits before start in the first byte are checked too
+    for (uint8_t n = 0; n <= SNAKE_GRID_SIZE; n++) {
+        const uint8_t freeBits = ~state->occupancy[byteIndex] & mask;
+        if (freeBits) {
+            uint8_t bit = 0;
+            while (!(freeBits & (1 << bit))) {
+                bit++;
+            }
+            return byteIndex * 8 + bit;
+        }
+        mask = 0xFF;
+        byteIndex = (byteIndex + 1) % SNAKE_GRID_SIZE;
+    }
+    return SNAKE_NO_FREE_CELL;
+}
+
+//! Random cell inside the walls
+static uint16_t snake_randomCell(SnakeState *state) {
+    const uint8_t x = 1 + snake_random(state) % SNAKE_FREE_COLUMNS(&state->field);
+    const uint8_t y = state->field.wallTop + 1 + snake_random(state) % SNAKE_FREE_ROWS(&state->field);
+    return snake_cellIndex(x, y);
+}
+
+//! Places food on a random free cell (or nowhere if the field is full)
+static void snake_placeFood(SnakeState *state) {
+    const uint16_t index = snake_findFreeCell(state, snake_randomCell(state));
+    if (index == SNAKE_NO_FREE_CELL) {
+        state->food = (SnakeCell){SNAKE_NO_CELL, SNAKE_NO_CELL};
+    } else {
+        state->food = (SnakeCell){index % SNAKE_COLUMNS, index / SNAKE_COLUMNS};
+    }
+}
+
+/*!
+ *  xorshift32, small and fast enough for an 8 bit CPU and identical on every
+ *  platform, which is what makes replays work.
+ */
+uint32_t snake_random(SnakeState *state) {
+    uint32_t x = state->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state->random = x;
+    return x;
+}
+
+/*!
+ *  \param state The game to query.
+ *  \param x     Column of the cell (0 .. SNAKE_COLUMNS - 1).
+ *  \param y     Row of the cell (0 .. SNAKE_ROWS - 1).
+ *  \return True if the cell belongs to the snake, a wall or lies outside of the walls.
+ */
+bool snake_isOccupied(const SnakeState *state, uint8_t x, uint8_t y) {
+    const uint16_t index = snake_cellIndex(x, y);
+    return state->occupancy[index / 8] & (1 << (index % 8));
+}
+
+/*!
+ *  The ring holds one direction per cell of the snake, so a snake filling
+ *  the whole field fits (rounded up to full bytes).
+ *
+ *  \param field Size of the field (at most SNAKE_COLUMNS x SNAKE_ROWS).
+ *  \return Number of bytes to pass as ring to snake_init.
+ */
+uint16_t snake_ringSize(const SnakeField *field) {
+    const uint16_t cells = (uint16_t)SNAKE_FREE_COLUMNS(field) * SNAKE_FREE_ROWS(field);
+    return PACKED_RING_BYTES(cells);
+}
+
+/*!
+ *  Starts a new game: the walls and everything outside of them are marked
+ *  as occupied, the snake (one cell) and the food are placed at random.
+ *
+ *  \param state The game to initialize.
+ *  \param field Size of the field, at most SNAKE_COLUMNS x SNAKE_ROWS with at least one free cell.
+ *  \param ring  Memory for the direction ring of snake_ringSize(field) bytes, it is used
+ *                until the game is initialized again.
+ *  \param seed  Seed of the PRNG, the same seed gives the same game for the same inputs.
+ */
+void snake_init(SnakeState *state, const SnakeField *field, uint8_t *ring, uint32_t seed) {
+    state->field = *field;
+    packedRing_init(&state->body, ring, snake_ringSize(field));
+    state->random = seed ? seed : 0x2545F491ul;
+
+    for (uint8_t y = 0; y < SNAKE_ROWS; y++) {
+        for (uint8_t x = 0; x < SNAKE_COLUMNS; x++) {
+            const bool wall = y <= field->wallTop || y >= field->rows - 1 || x == 0 || x >= field->columns - 1;
+            snake_mark(state, (SnakeCell){x, y}, wall);
+        }
+    }
+
+    const uint16_t start = snake_randomCell(state);
+    state->head = (SnakeCell){start % SNAKE_COLUMNS, start / SNAKE_COLUMNS};
+    state->tail = state->head;
+    snake_mark(state, state->head, true);
+    state->direction = snake_random(state) % 4;
+    state->length = 1;
+    state->score = 0;
+    state->growing = false;
+    state->alive = true;
+    state->steps = 0;
+    snake_placeFood(state);
+}
+
+/*!
+ *  Advances the game by one step. The tail is released before the new head
+ *  is checked, so the head may follow the tail directly. Turning around onto
+ *  the own body is a collision like any other.
+ *
+ *  \param state The game to advance.
+ *  \param input New direction or SNAKE_KEEP.
+ *  \return The changed cells, no events if the game is already over.
+ */
+SnakeStepResult snake_step(SnakeState *state, SnakeDir input) {
+    SnakeStepResult result = {0};
+    if (!state->alive) {
+        return result;
+    }
+    if (input != SNAKE_KEEP) {
+        state->direction = input;
+    }
+
+    result.oldHead = state->head;
+    packedRing_pushHead(&state->body, state->direction);
+    state->head = snake_move(state->head, state->direction);
+    result.events = SNAKE_EVENT_MOVED;
+
+    if (state->growing) {
+        state->growing = false;
+    } else {
+        snake_mark(state, state->tail, false);
+        result.freedTail = state->tail;
+        result.events |= SNAKE_EVENT_TAIL_FREED;
+        state->tail = snake_move(state->tail, packedRing_popTail(&state->body));
+    }
+
+    state->steps++;
+    if (snake_isOccupied(state, state->head.x, state->head.y)) {
+        state->alive = false;
+        result.events |= SNAKE_EVENT_DIED;
+        return result;
+    }
+    snake_mark(state, state->head, true);
+
+    if (state->head.x == state->food.x && state->head.y == state->food.y) {
+        state->score++;
+        if (state->length < state->body.capacity) {
+            state->length++;
+            state->growing = true;
+        }
+        snake_placeFood(state);
+        result.events |= SNAKE_EVENT_ATE;
+    }
+    return result;
+}
+
+static void snake_writeU32(uint8_t *buffer, uint32_t value) {
+    for (uint8_t i = 0; i < 4; i++) {
+        buffer[i] = value >> (8 * i);
+    }
+}
+
+static uint32_t snake_readU32(const uint8_t *buffer) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        value |= (uint32_t)buffer[i] << (8 * i);
+    }
+    return value;
+}
+
+/*!
+ *  Starts recording a replay. The header is written right away and updated
+ *  with every step, so the buffer always holds a complete replay.
+ *
+ *  \param replay   The replay to start.
+ *  \param buffer   Memory for the replay.
+ *  \param capacity Size of buffer in bytes (at least SNAKE_REPLAY_HEADER_SIZE).
+ *  \param field    Field the game was started on.
+ *  \param seed     Seed the game was started with.
+ */
+void snake_replayStart(SnakeReplay *replay, uint8_t *buffer, uint16_t capacity, const SnakeField *field, uint32_t seed) {
+    replay->buffer = buffer;
+    replay->capacity = capacity;
+    replay->field = *field;
+    replay->seed = seed;
+    replay->steps = 0;
+    if (capacity < SNAKE_REPLAY_HEADER_SIZE) {
+        replay->capacity = 0;
+        return;
+    }
+    buffer[0] = 'S';
+    buffer[1] = 'R';
+    buffer[2] = SNAKE_REPLAY_VERSION;
+    buffer[3] = field->columns;
+    buffer[4] = field->rows;
+    buffer[5] = field->wallTop;
+    snake_writeU32(buffer + 6, seed);
+    snake_writeU32(buffer + 10, 0);
+}
+
+/*!
+ *  \param replay    The replay to append to.
+ *  \param direction Direction of the snake after the step.
+ *  \return False if the buffer is full, the step is not recorded then.
+ */
+bool snake_replayRecord(SnakeReplay *replay, SnakeDir direction) {
+    const uint32_t byte = SNAKE_REPLAY_HEADER_SIZE + replay->steps / 4;
+    if (byte >= replay->capacity) {
+        return false;
+    }
+    const uint8_t shift = (replay->steps % 4) * 2;
+    uint8_t *data = &replay->buffer[byte];
+    *data = (shift ? *data : 0) | ((direction & 0x03) << shift);
+    replay->steps++;
+    snake_writeU32(replay->buffer + 10, replay->steps);
+    return true;
+}
+
+//! \return Number of bytes that make up the replay
+uint16_t snake_replaySize(const SnakeReplay *replay) {
+    return SNAKE_REPLAY_HEADER_SIZE + (replay->steps + 3) / 4;
+}
+
+/*!
+ *  \param replay The replay to fill.
+ *  \param buffer A recorded replay.
+ *  \param size   Number of valid bytes in buffer.
+ *  \return False if the magic or version do not match or the data is truncated.
+ */
+bool snake_replayOpen(SnakeReplay *replay, uint8_t *buffer, uint16_t size) {
+    if (size < SNAKE_REPLAY_HEADER_SIZE || buffer[0] != 'S' || buffer[1] != 'R' || buffer[2] != SNAKE_REPLAY_VERSION) {
+        return false;
+    }
+    replay->buffer = buffer;
+    replay->capacity = size;
+    replay->field = (SnakeField){buffer[3], buffer[4], buffer[5]};
+    replay->seed = snake_readU32(buffer + 6);
+    replay->steps = snake_readU32(buffer + 10);
+    return snake_replaySize(replay) <= size;
+}
+
+//! \return The direction recorded for a step (step < replay->steps)
+SnakeDir snake_replayDirection(const SnakeReplay *replay, uint32_t step) {
+    const uint8_t data = replay->buffer[SNAKE_REPLAY_HEADER_SIZE + step / 4];
+    return (data >> ((step % 4) * 2)) & 0x03;
+}
@@ -0,0 +1,152 @@
+/*! \file
+ *  \brief Hardware independent game logic of snake
+ *
+ *  The engine knows nothing about the panel, the joystick or the system time.
+ *  snake_step gets the input of one step and reports which cells changed, so
+ *  a renderer can draw exactly these. Food is placed with a seedable PRNG, so
+ *  a game is fully determined by its seed and the directions of its steps,
+ *  which can be recorded as a compact replay.
+ *
+ *  Only standard C is used, so the engine can be compiled for a host as well.
+ */
+#ifndef _SNAKE_ENGINE_H
+#define _SNAKE_ENGINE_H
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "packed_ring.h"
+
+//! Maximum size of a field (the whole panel)
+#define SNAKE_COLUMNS 32
+#define SNAKE_ROWS 32
+
+//! Row of the upper wall of a field that spans the whole panel, the rows above show the score
+#define SNAKE_DEFAULT_WALL_TOP 5
+
+//! Occupancy grid: one bit per cell of the largest field (128 bytes)
+#define SNAKE_GRID_SIZE (SNAKE_COLUMNS * SNAKE_ROWS / 8)
+
+//! Coordinate of a cell that does not exist (e.g. no food because the field is full)
+#define SNAKE_NO_CELL 0xFF
+
+//! Directions of the snake, the opposite direction of d is d ^ 2
+typedef enum {
+    SNAKE_UP = 0,
+    SNAKE_RIGHT = 1,
+    SNAKE_DOWN = 2,
+    SNAKE_LEFT = 3,
+    //! Input of a step without a new direction
+    SNAKE_KEEP = 4
+} SnakeDir;
+
+//! A cell of the grid
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+} SnakeCell;
+
+//! Event flags of SnakeStepResult
+#define SNAKE_EVENT_MOVED 0x01
+#define SNAKE_EVENT_TAIL_FREED 0x02
+#define SNAKE_EVENT_ATE 0x04
+#define SNAKE_EVENT_DIED 0x08
+
+//! What a step changed, everything a renderer needs to update the display
+typedef struct {
+    //! Combination of SNAKE_EVENT_* flags
+    uint8_t events;
+    //! Cell of the head before the step (now a body cell)
+    SnakeCell oldHead;
+    //! Cell that was left by the tail (SNAKE_EVENT_TAIL_FREED)
+    SnakeCell freedTail;
+} SnakeStepResult;
+
+/*!
+ *  Size of a field. The walls are the first and the last column, the last row
+ *  and row wallTop; the rows above wallTop are left for the score.
+ */
+typedef struct {
+    uint8_t columns;
+    uint8_t rows;
+    uint8_t wallTop;
+} SnakeField;
+
+//! Complete state of one game
+typedef struct {
+    SnakeField field;
+    //! Cells occupied by the snake, the walls and everything outside of them
+    uint8_t occupancy[SNAKE_GRID_SIZE];
+    //! For each body cell from the tail the direction to the next cell, its capacity limits the length
+    PackedRing body;
+    SnakeCell head;
+    SnakeCell tail;
+    SnakeCell food;
+    SnakeDir direction;
+    uint16_t length;
+    uint16_t score;
+    //! Whether the tail stays in place on the next step because food was eaten
+    bool growing;
+    bool alive;
+    //! Number of steps since snake_init
+    uint32_t steps;
+    //! State of the xorshift PRNG, never 0
+    uint32_t random;
+} SnakeState;
+
+//! Size in bytes of the direction ring a field needs (room for a snake filling the field)
+uint16_t snake_ringSize(const SnakeField *field);
+
+//! Starts a new game on a field, the seed determines the start position and all food
+void snake_init(SnakeState *state, const SnakeField *field, uint8_t *ring, uint32_t seed);
+
+//! Performs one step with the given input
+SnakeStepResult snake_step(SnakeState *state, SnakeDir input);
+
+//! Whether a cell is occupied by the snake, a wall or lies outside of the walls
+bool snake_isOccupied(const SnakeState *state, uint8_t x, uint8_t y);
+
+//! Next value of the PRNG of a game
+uint32_t snake_random(SnakeState *state);
+
+
+/*!
+ *  Replays are stored as a header followed by the direction of every step,
+ *  2 bits per step and 4 steps per byte (first step in bits 0-1). Since the
+ *  direction after a step is what snake_step is fed with on playback, the
+ *  replay reproduces the game exactly. All numbers are little endian:
+ *
+ *    offset 0: 'S' 'R'        magic
+ *    offset 2: version        SNAKE_REPLAY_VERSION
+ *    offset 3: field          columns, rows, wallTop
+ *    offset 6: seed           4 bytes
+ *    offset 10: steps         4 bytes
+ *    offset 14: directions    (steps + 3) / 4 bytes
+ */
+#define SNAKE_REPLAY_VERSION 1
+#define SNAKE_REPLAY_HEADER_SIZE 14
+
+//! Replay in a caller provided buffer (the "file" that can be stored or sent)
+typedef struct {
+    uint8_t *buffer;
+    uint16_t capacity;
+    SnakeField field;
+    uint32_t seed;
+    uint32_t steps;
+} SnakeReplay;
+
+//! Starts recording into a buffer of capacity bytes
+void snake_replayStart(SnakeReplay *replay, uint8_t *buffer, uint16_t capacity, const SnakeField *field, uint32_t seed);
+
+//! Appends the direction of a step, returns false if the buffer is full
+bool snake_replayRecord(SnakeReplay *replay, SnakeDir direction);
+
+//! Number of bytes of the replay (header and directions)
+uint16_t snake_replaySize(const SnakeReplay *replay);
+
+//! Opens a recorded replay, returns false if the buffer does not contain one
+bool snake_replayOpen(SnakeReplay *replay, uint8_t *buffer, uint16_t size);
+
+//! Direction of a step of the replay
+SnakeDir snake_replayDirection(const SnakeReplay *replay, uint32_t step);
+
+#endif
@@ -89,6 +89,17 @@ Time os_systemTime_precise(void) {
 }
 
 
+/*!
+ * Function that returns the current systemtime in timer 0 ticks, without the division to ms.
+ * Differences of two values are short intervals with a resolution of ~ 13 us.
+ *
+ * \return The raw augmented system time
+ */
+Time os_systemTime_ticks(void) {
+    return os_systemTime_augment();
+}
+
+
 /*!
  *  Function that may be used to wait for specific time intervals.
  *  Therefore, we calculate the relative time to wait. This value is added to the current system time
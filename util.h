@@ -31,6 +31,15 @@ Time os_systemTime_coarse(void);
 //! Precise system time in ms
 Time os_systemTime_precise(void);
 
+//! System time in ticks of timer 0 (TC0_PRESCALER / F_CPU = 12.8 us), for measuring short intervals
+Time os_systemTime_ticks(void);
+
+//! Converts a number of timer 0 ticks to milliseconds (the unit of os_systemTime_precise)
+#define TIME_TICKS_TO_MS(ticks) ((ticks) / (F_CPU / (TC0_PRESCALER * 1000ul)))
+
+//! Converts a number of timer 0 ticks to microseconds
+#define TIME_TICKS_TO_US(ticks) ((ticks) * TC0_PRESCALER / (F_CPU / 1000000ul))
+
 //! Waits for some milliseconds
 void delayMs(Time ms);
 